@@ -0,0 +1,122 @@
+// Parser-only throughput benchmark. The file is split among the threads like in the host application, but the edges
+// are only parsed, without being sent anywhere
+#include <fcntl.h>
+#include <pthread.h>  // Threads
+#include <stdbool.h>  // Booleans
+#include <stdint.h>   // Fixed size integers
+#include <stdio.h>    // Print
+#include <stdlib.h>   // Various
+#include <sys/mman.h> // mmap
+#include <sys/stat.h>
+#include <sys/time.h> // Measure execution time
+#include <unistd.h>
+
+#include "../common/common.h"
+#include "../host/coo_parser.h"
+
+typedef struct {
+	uint32_t    th_id;
+	const char* mmaped_file;
+	uint64_t    file_size;
+	uint64_t    from_char;
+	uint64_t    to_char;
+
+	// Results
+	uint64_t edges;
+	uint64_t checksum; // Prevents the compiler from removing the parsing
+	double   seconds;
+} parser_bench_args_t;
+
+static void* parse_section(void* args_thread) {
+	parser_bench_args_t* args = (parser_bench_args_t*)args_thread;
+
+	struct timeval start, end;
+	gettimeofday(&start, 0);
+
+	uint64_t pos = args->from_char;
+	if (pos != 0 && args->mmaped_file[pos - 1] != '\n') {
+		pos = find_next_newline(args->mmaped_file, pos, args->to_char) + 1;
+	}
+
+	edge_t edge;
+	bool   is_valid_edge;
+	while (pos < args->to_char) {
+		pos = parse_coo_line(args->mmaped_file, pos, args->file_size, &edge, &is_valid_edge);
+		if (is_valid_edge) {
+			args->edges++;
+			args->checksum += edge.u ^ edge.v;
+		}
+	}
+
+	gettimeofday(&end, 0);
+	args->seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+
+	return NULL;
+}
+
+int main(int argc, char* argv[]) {
+
+	if (argc < 2) {
+		printf("Usage: %s path_to_graph_file [nr_threads]\n", argv[0]);
+		return 1;
+	}
+
+	uint32_t nr_threads = (argc > 2) ? atoi(argv[2]) : 1;
+	if (nr_threads == 0) {
+		printf("Invalid number of threads.\n");
+		return 1;
+	}
+
+	struct stat file_stat;
+	if (stat(argv[1], &file_stat) != 0) {
+		printf("File does not exist.\n");
+		return 1;
+	}
+
+	// Load the whole file before starting, so that only the parsing is measured
+	int   file_fd     = open(argv[1], O_RDONLY);
+	char* mmaped_file = (char*)mmap(0, file_stat.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, file_fd, 0);
+	close(file_fd);
+
+	pthread_t*           threads = malloc(nr_threads * sizeof(pthread_t));
+	parser_bench_args_t* args    = malloc(nr_threads * sizeof(parser_bench_args_t));
+
+	uint64_t char_per_thread = file_stat.st_size / nr_threads;
+	for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+		args[th_id] = (parser_bench_args_t){
+		    .th_id       = th_id,
+		    .mmaped_file = mmaped_file,
+		    .file_size   = file_stat.st_size,
+		    .from_char   = char_per_thread * th_id,
+		    .to_char     = (th_id == nr_threads - 1) ? (uint64_t)file_stat.st_size : char_per_thread * (th_id + 1),
+		    .edges       = 0,
+		    .checksum    = 0,
+		    .seconds     = 0,
+		};
+		pthread_create(&threads[th_id], NULL, parse_section, (void*)&args[th_id]);
+	}
+
+	uint64_t total_edges    = 0;
+	uint64_t total_checksum = 0;
+	double   max_seconds    = 0;
+	for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+		pthread_join(threads[th_id], NULL);
+
+		double gigabytes = (args[th_id].to_char - args[th_id].from_char) / 1e9;
+		printf("Thread %u: %lu edges, %f GB/s\n", th_id, args[th_id].edges, gigabytes / args[th_id].seconds);
+
+		total_edges += args[th_id].edges;
+		total_checksum += args[th_id].checksum;
+		max_seconds = (args[th_id].seconds > max_seconds) ? args[th_id].seconds : max_seconds;
+	}
+
+	printf("Parser block size: %d bytes\n", PARSER_BLOCK_SIZE);
+	printf("Total: %lu edges (checksum %lu), %f GB/s\n", total_edges, total_checksum,
+	       file_stat.st_size / 1e9 / max_seconds);
+
+	munmap(mmaped_file, file_stat.st_size);
+	free(threads);
+	free(args);
+
+	return 0;
+}
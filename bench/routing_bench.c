@@ -0,0 +1,169 @@
+// Routing throughput benchmark. Random edges are colored and copied to the batches of their DPUs like in the host
+// application, once writing each edge directly to its batches and once gathering the edges in write-combining buffers
+#include <stdint.h>   // Fixed size integers
+#include <stdio.h>    // Print
+#include <stdlib.h>   // Various
+#include <string.h>   // memset
+#include <sys/time.h> // Measure execution time
+
+#include "../common/common.h"
+#include "../host/routing.h"
+#include "../host/write_combining.h"
+
+// Edges of each batch. The batches are overwritten from the start when full, like the chunks given back to the pool
+#define BENCH_BATCH_EDGES (4 * 1024)
+
+static const uint32_t bench_colors[] = {8, 16, 32};
+
+typedef struct {
+	edge_t*   edges;
+	uint32_t* sizes;
+	uint32_t  nr_batches;
+} bench_batches_t;
+
+static double get_seconds(struct timeval start, struct timeval end) {
+	return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+}
+
+static inline uint64_t splitmix64(uint64_t* state) {
+	uint64_t z = (*state += 0x9E3779B97F4A7C15);
+	z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+	z          = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+	return z ^ (z >> 31);
+}
+
+// Write each edge to all its batches
+static void route_direct(const routing_table_t* routing, const edge_t* edges, uint64_t nr_edges,
+                         bench_batches_t* batches) {
+	uint32_t dpu_ids_offsets[ROUTING_BLOCK_EDGES];
+
+	for (uint64_t from = 0; from < nr_edges; from += ROUTING_BLOCK_EDGES) {
+		uint32_t nr_block_edges = (nr_edges - from < ROUTING_BLOCK_EDGES) ? nr_edges - from : ROUTING_BLOCK_EDGES;
+		route_edges(routing, &edges[from], nr_block_edges, dpu_ids_offsets);
+
+		for (uint32_t i = 0; i < nr_block_edges; i++) {
+			const uint16_t* dpu_ids = &routing->dpu_ids[dpu_ids_offsets[i]];
+			for (uint32_t j = 0; j < routing->colors; j++) {
+				uint32_t batch = dpu_ids[j];
+				batches->edges[(uint64_t)batch * BENCH_BATCH_EDGES + batches->sizes[batch]] = edges[from + i];
+				batches->sizes[batch] = (batches->sizes[batch] + 1) % BENCH_BATCH_EDGES;
+			}
+		}
+	}
+}
+
+// Gather the edges of each batch in a cache line, and copy the full lines to the batches
+static void route_write_combining(const routing_table_t* routing, const edge_t* edges, uint64_t nr_edges,
+                                  bench_batches_t* batches, wc_buffers_t* wc_buffers) {
+	uint32_t dpu_ids_offsets[ROUTING_BLOCK_EDGES];
+
+	for (uint64_t from = 0; from < nr_edges; from += ROUTING_BLOCK_EDGES) {
+		uint32_t nr_block_edges = (nr_edges - from < ROUTING_BLOCK_EDGES) ? nr_edges - from : ROUTING_BLOCK_EDGES;
+		route_edges(routing, &edges[from], nr_block_edges, dpu_ids_offsets);
+
+		for (uint32_t i = 0; i < nr_block_edges; i++) {
+			const uint16_t* dpu_ids = &routing->dpu_ids[dpu_ids_offsets[i]];
+			for (uint32_t j = 0; j < routing->colors; j++) {
+				uint32_t batch = dpu_ids[j];
+				if (add_to_wc_buffer(wc_buffers, batch, edges[from + i])) {
+					// The batches are a multiple of a line, so the full lines never wrap around
+					copy_edges_to_batch(&batches->edges[(uint64_t)batch * BENCH_BATCH_EDGES + batches->sizes[batch]],
+					                    get_wc_buffer(wc_buffers, batch), WC_BUFFER_EDGES);
+					batches->sizes[batch] = (batches->sizes[batch] + WC_BUFFER_EDGES) % BENCH_BATCH_EDGES;
+					clear_wc_buffer(wc_buffers, batch);
+				}
+			}
+		}
+	}
+
+	for (uint32_t batch = 0; batch < batches->nr_batches; batch++) {
+		copy_edges_to_batch(&batches->edges[(uint64_t)batch * BENCH_BATCH_EDGES + batches->sizes[batch]],
+		                    get_wc_buffer(wc_buffers, batch), wc_buffers->nr_edges[batch]);
+		batches->sizes[batch] += wc_buffers->nr_edges[batch];
+		clear_wc_buffer(wc_buffers, batch);
+	}
+	store_fence();
+}
+
+// Both versions write the same edges in the same cells
+static uint64_t get_batches_checksum(const bench_batches_t* batches) {
+	uint64_t checksum = 0;
+	for (uint64_t i = 0; i < (uint64_t)batches->nr_batches * BENCH_BATCH_EDGES; i++) {
+		checksum = checksum * 31 + (((uint64_t)batches->edges[i].u << 32) | batches->edges[i].v);
+	}
+	return checksum;
+}
+
+static void reset_batches(bench_batches_t* batches) {
+	memset(batches->edges, 0, (uint64_t)batches->nr_batches * BENCH_BATCH_EDGES * sizeof(edge_t));
+	memset(batches->sizes, 0, batches->nr_batches * sizeof(uint32_t));
+}
+
+int main(int argc, char* argv[]) {
+
+	uint64_t nr_edges = (argc > 1) ? strtoull(argv[1], NULL, 10) : 4 * 1024 * 1024;
+	int32_t  seed     = (argc > 2) ? atoi(argv[2]) : 0;
+	if (nr_edges == 0) {
+		printf("Usage: %s [nr_edges] [seed]\n", argv[0]);
+		return 1;
+	}
+
+	edge_t*  edges = malloc(nr_edges * sizeof(edge_t));
+	uint64_t state = seed;
+	for (uint64_t i = 0; i < nr_edges; i++) {
+		uint64_t random = splitmix64(&state);
+		uint32_t u      = random >> 32;
+		uint32_t v      = (uint32_t)random;
+		edges[i]        = (u < v) ? (edge_t){u, v} : (edge_t){v, u};
+	}
+
+	for (uint32_t c = 0; c < sizeof(bench_colors) / sizeof(bench_colors[0]); c++) {
+		uint32_t colors      = bench_colors[c];
+		uint32_t nr_triplets = colors * (colors + 1) * (colors + 2) / 6;
+
+		routing_table_t routing;
+		create_routing_table(&routing, colors, get_hash_parameters(seed, 0));
+
+		bench_batches_t batches = {
+		    .edges      = aligned_alloc(CACHE_LINE_SIZE, (uint64_t)nr_triplets * BENCH_BATCH_EDGES * sizeof(edge_t)),
+		    .sizes      = malloc(nr_triplets * sizeof(uint32_t)),
+		    .nr_batches = nr_triplets,
+		};
+		wc_buffers_t wc_buffers;
+		create_wc_buffers(&wc_buffers, nr_triplets);
+
+		struct timeval start, end;
+
+		// The batches are written once before measuring, so that the page faults are not counted
+		reset_batches(&batches);
+		gettimeofday(&start, 0);
+		route_direct(&routing, edges, nr_edges, &batches);
+		gettimeofday(&end, 0);
+		double   direct_seconds  = get_seconds(start, end);
+		uint64_t direct_checksum = get_batches_checksum(&batches);
+
+		reset_batches(&batches);
+		gettimeofday(&start, 0);
+		route_write_combining(&routing, edges, nr_edges, &batches, &wc_buffers);
+		gettimeofday(&end, 0);
+		double   wc_seconds  = get_seconds(start, end);
+		uint64_t wc_checksum = get_batches_checksum(&batches);
+
+		printf("C=%u (%u triplets): direct %f M edges/s, write-combining %f M edges/s, speedup %f\n", colors,
+		       nr_triplets, nr_edges / direct_seconds / 1e6, nr_edges / wc_seconds / 1e6, direct_seconds / wc_seconds);
+		if (direct_checksum != wc_checksum) {
+			printf("Different batches: checksum %lu, expected %lu\n", wc_checksum, direct_checksum);
+			return 1;
+		}
+
+		delete_wc_buffers(&wc_buffers);
+		free(batches.edges);
+		free(batches.sizes);
+		delete_routing_table(&routing);
+	}
+
+	printf("Line buffers: %lu edges, routing block: %d edges\n", (uint64_t)WC_BUFFER_EDGES, ROUTING_BLOCK_EDGES);
+	free(edges);
+
+	return 0;
+}
@@ -8,9 +8,14 @@ typedef struct {
 	uint32_t seed;
 	uint32_t sample_size;
 	uint32_t t;
+	uint32_t has_deletions;    // The batches have deletions, flagged with EDGE_DELETION_FLAG
+	uint32_t has_local_counts; // Count the triangles of each node of the sample, see node_triangles_t
 	uint32_t padding;
 } dpu_arguments_t;
 
+// Execution codes: 0 adds the received batch to the sample, 1 counts the triangles of the sample, 2 resets the DPU so
+// that it can receive a new graph without being loaded again, 3 counts the triangles like 1 but keeps the sample, so
+// that more batches can be added to it
 typedef struct {
 	uint32_t execution_code;
 	uint32_t max_node_id;
@@ -22,13 +27,22 @@ typedef struct {
 	uint32_t v;
 } edge_t;
 
+// Set in u for the deletions of the fully dynamic graphs. Their node ids must then be lower than 2^31
+#define EDGE_DELETION_FLAG 0x80000000
+
 // Contains a pair of colors, representing the colors of an edge
 typedef struct {
 	uint32_t color_u;
 	uint32_t color_v;
 } edge_colors_t;
 
-// Used to store information about nodes while using Misra-Gries
+// Triangles of a node in the sample of a DPU, read by the host for the local counts. A node can have several pairs
+typedef struct {
+	uint32_t node_id;
+	uint32_t triangles;
+} node_triangles_t;
+
+// Used to store information about the top frequent nodes
 typedef struct {
 	uint32_t node_id;
 	int32_t  frequency;
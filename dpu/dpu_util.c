@@ -21,6 +21,51 @@ uint32_t rand_range(uint32_t from, uint32_t to) {
 	return (rand() % (to - from + 1) + from);
 }
 
+double get_random_pairing_probability(uint32_t total_edges, uint32_t deletions, uint32_t sample_size,
+                                      uint32_t edges_in_sample) {
+	// The sample has no triangles
+	if (edges_in_sample < 3) {
+		return 1;
+	}
+
+	double s     = total_edges;
+	double d     = deletions;
+	double omega = (sample_size < s + d) ? sample_size : s + d;
+
+	// Probability that the sample has at least three edges of the graph. The hypergeometric probability that it has j
+	// edges of the graph is binom(s, j) * binom(d, omega - j) / binom(s + d, omega), which is 0 for every j < 3 if
+	// there are few deletions. Otherwise the three terms share the product of (d - i) / (s + d - i) for
+	// 0 <= i < omega - 2, which is not computed further once it is negligible
+	double kappa = 1;
+	if (d + 2 >= omega) {
+		double product = 1;
+		for (uint32_t i = 0; i + 3 <= omega && product > 1e-30; i++) {
+			product *= (d - i) / (s + d - i);
+		}
+
+		double denominator = (s + d - omega + 2) * (s + d - omega + 1);
+		double none        = product * (d - omega + 2) * (d - omega + 1) / denominator;
+		double one         = product * s * omega * (d - omega + 2) / denominator;
+		double two         = product * s * (s - 1) / 2 * omega * (omega - 1) / denominator;
+		kappa              = 1 - none - one - two;
+	}
+
+	// The edges of the sample are a uniform sample of the edges of the graph
+	return kappa * (edges_in_sample / s) * ((edges_in_sample - 1) / (s - 1)) * ((edges_in_sample - 2) / (s - 2));
+}
+
+void copy_sample(__mram_ptr edge_t* from, __mram_ptr edge_t* to, uint32_t nr_edges, edge_t* wram_buffer_ptr) {
+	uint32_t max_edges_in_buffer = WRAM_BUFFER_SIZE / sizeof(edge_t);
+
+	for (uint32_t copied_edges = 0; copied_edges < nr_edges; copied_edges += max_edges_in_buffer) {
+		uint32_t edges_to_copy = nr_edges - copied_edges;
+		edges_to_copy          = (edges_to_copy < max_edges_in_buffer) ? edges_to_copy : max_edges_in_buffer;
+
+		mram_read(&from[copied_edges], wram_buffer_ptr, edges_to_copy * sizeof(edge_t));
+		mram_write(wram_buffer_ptr, &to[copied_edges], edges_to_copy * sizeof(edge_t));
+	}
+}
+
 void frequent_nodes_remapping(__mram_ptr edge_t* sample, uint32_t from_edge, uint32_t to_edge, edge_t* sample_buffer,
                               uint32_t nr_top_nodes, node_frequency_t* top_frequent_nodes, uint32_t max_node_id) {
 
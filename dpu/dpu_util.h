@@ -20,6 +20,14 @@ uint32_t rand_range(uint32_t from, uint32_t to); // from and to are included
 void frequent_nodes_remapping(__mram_ptr edge_t* sample, uint32_t from_edge, uint32_t to_edge, edge_t* sample_buffer,
                               uint32_t nr_top_nodes, node_frequency_t* top_frequent_nodes, uint32_t max_node_id);
 
+// Probability that the three edges of a triangle of a fully dynamic graph are in the sample (random pairing, as in
+// TRIEST-FD). total_edges is the number of edges of the graph, and deletions the deletions not compensated yet
+double get_random_pairing_probability(uint32_t total_edges, uint32_t deletions, uint32_t sample_size,
+                                      uint32_t edges_in_sample);
+
+// Copy edges between two areas of the MRAM, which must not overlap, through the WRAM buffer
+void copy_sample(__mram_ptr edge_t* from, __mram_ptr edge_t* to, uint32_t nr_edges, edge_t* wram_buffer_ptr);
+
 // Debug function for printing the content of the sample
 void print_sample(__mram_ptr edge_t* sample, uint32_t edges_in_sample);
 
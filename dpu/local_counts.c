@@ -0,0 +1,179 @@
+#include <attributes.h> // For __dma_aligned
+#include <defs.h>       // Get tasklet id
+#include <mram.h>       // Transfer data between WRAM and MRAM. Access MRAM
+#include <mutex.h>      // Mutex for tasklets
+#include <stdbool.h>    // Booleans
+#include <stdint.h>     // Fixed size integers
+
+#include "../common/common.h"
+#include "dpu_util.h"
+#include "local_counts.h"
+#include "locate_nodes.h"
+
+#define COUNTERS_PER_UPDATE 8 // Counters read from the MRAM at a time by add_edge_triangles, on the stack
+
+__mram_ptr edge_triangles_t* edge_triangles;
+MUTEX_INIT(update_edge_counters); // The MRAM is written 8 bytes at a time, so both counters of an edge are rewritten
+
+// Offsets in the pairs to compact, and in the compacted pairs, common for all tasklets
+uint32_t global_pairs_read_offset  = 0;
+uint32_t global_pairs_write_offset = 0;
+MUTEX_INIT(compact_pairs);
+
+void reset_local_counts() {
+	global_pairs_read_offset  = 0;
+	global_pairs_write_offset = 0;
+}
+
+void init_local_counts(__mram_ptr edge_triangles_t* counters, uint32_t from_edge, uint32_t to_edge,
+                       void* wram_buffer_ptr) {
+	edge_triangles = counters; // Does not matter if set by all tasklets
+
+	uint32_t          max_counters_in_buffer = WRAM_BUFFER_SIZE / sizeof(edge_triangles_t);
+	edge_triangles_t* counters_buffer        = (edge_triangles_t*)wram_buffer_ptr;
+	for (uint32_t i = 0; i < max_counters_in_buffer; i++) {
+		counters_buffer[i] = (edge_triangles_t){0, 0};
+	}
+
+	for (uint32_t edge_index = from_edge; edge_index < to_edge; edge_index += max_counters_in_buffer) {
+		uint32_t counters_to_clear = to_edge - edge_index;
+		counters_to_clear = (counters_to_clear < max_counters_in_buffer) ? counters_to_clear : max_counters_in_buffer;
+		mram_write(counters_buffer, &edge_triangles[edge_index], counters_to_clear * sizeof(edge_triangles_t));
+	}
+}
+
+void add_edge_triangles(uint32_t first_edge, edge_triangles_t* triangles, uint32_t nr_edges) {
+	__dma_aligned edge_triangles_t counters[COUNTERS_PER_UPDATE];
+
+	mutex_lock(update_edge_counters);
+	for (uint32_t offset = 0; offset < nr_edges; offset += COUNTERS_PER_UPDATE) {
+		uint32_t counters_to_update = nr_edges - offset;
+		counters_to_update = (counters_to_update < COUNTERS_PER_UPDATE) ? counters_to_update : COUNTERS_PER_UPDATE;
+		mram_read(&edge_triangles[first_edge + offset], counters, counters_to_update * sizeof(edge_triangles_t));
+		for (uint32_t i = 0; i < counters_to_update; i++) {
+			counters[i].as_first += triangles[offset + i].as_first;
+			counters[i].as_last += triangles[offset + i].as_last;
+		}
+		mram_write(counters, &edge_triangles[first_edge + offset], counters_to_update * sizeof(edge_triangles_t));
+	}
+	mutex_unlock(update_edge_counters);
+}
+
+void count_first_node_triangles(__mram_ptr edge_t* sorted_sample, uint32_t edges_in_sample, uint32_t num_locations,
+                                __mram_ptr node_loc_t* node_locations, void* wram_buffer_ptr) {
+	// Half of the WRAM buffer for the node locations, replaced in place by the pairs. A quarter for the edges starting
+	// with a node, and a quarter for their counters
+	uint32_t          max_locations_in_buffer = (WRAM_BUFFER_SIZE >> 1) / sizeof(node_loc_t);
+	uint32_t          max_edges_in_buffer     = (WRAM_BUFFER_SIZE >> 2) / sizeof(edge_t);
+	node_loc_t*       locations_buffer        = (node_loc_t*)wram_buffer_ptr;
+	node_triangles_t* pairs_buffer            = (node_triangles_t*)wram_buffer_ptr;
+	edge_t*           edges_buffer            = (edge_t*)(wram_buffer_ptr + (WRAM_BUFFER_SIZE >> 1));
+	edge_triangles_t* counters_buffer = (edge_triangles_t*)(wram_buffer_ptr + (WRAM_BUFFER_SIZE >> 1) +
+	                                                        (WRAM_BUFFER_SIZE >> 2));
+
+	// Split the node locations equally among the tasklets
+	uint32_t locations_per_tasklet = num_locations / NR_TASKLETS;
+	uint32_t from_location         = locations_per_tasklet * me();
+	uint32_t to_location = (me() == NR_TASKLETS - 1) ? num_locations : locations_per_tasklet * (me() + 1);
+
+	for (uint32_t location = from_location; location < to_location; location += max_locations_in_buffer) {
+		uint32_t locations_in_buffer = to_location - location;
+		locations_in_buffer =
+		    (locations_in_buffer < max_locations_in_buffer) ? locations_in_buffer : max_locations_in_buffer;
+		mram_read(&node_locations[location], locations_buffer, locations_in_buffer * sizeof(node_loc_t));
+
+		for (uint32_t i = 0; i < locations_in_buffer; i++) {
+			uint32_t node_id   = locations_buffer[i].id;
+			uint32_t triangles = 0;
+
+			// The sample is sorted, the edges starting with the node follow its first one
+			bool     is_node_over = false;
+			uint32_t first_edge   = locations_buffer[i].index_in_sample;
+			for (uint32_t edge_index = first_edge; edge_index < edges_in_sample && !is_node_over;
+			     edge_index += max_edges_in_buffer) {
+				uint32_t edges_in_buffer = edges_in_sample - edge_index;
+				edges_in_buffer = (edges_in_buffer < max_edges_in_buffer) ? edges_in_buffer : max_edges_in_buffer;
+				mram_read(&sorted_sample[edge_index], edges_buffer, edges_in_buffer * sizeof(edge_t));
+				mram_read(&edge_triangles[edge_index], counters_buffer, edges_in_buffer * sizeof(edge_triangles_t));
+
+				for (uint32_t j = 0; j < edges_in_buffer; j++) {
+					if (edges_buffer[j].u != node_id) {
+						is_node_over = true;
+						break;
+					}
+					triangles += counters_buffer[j].as_first;
+				}
+			}
+
+			pairs_buffer[i] = (node_triangles_t){node_id, triangles};
+		}
+
+		mram_write(pairs_buffer, &node_locations[location], locations_in_buffer * sizeof(node_triangles_t));
+	}
+}
+
+void count_second_node_triangles(__mram_ptr edge_t* sorted_sample, uint32_t from_edge, uint32_t to_edge,
+                                 void* wram_buffer_ptr) {
+	// Half of the WRAM buffer for the edges, and half for their counters, replaced in place by the pairs
+	uint32_t          max_edges_in_buffer = (WRAM_BUFFER_SIZE >> 1) / sizeof(edge_t);
+	edge_t*           edges_buffer        = (edge_t*)wram_buffer_ptr;
+	edge_triangles_t* counters_buffer     = (edge_triangles_t*)(wram_buffer_ptr + (WRAM_BUFFER_SIZE >> 1));
+	node_triangles_t* pairs_buffer        = (node_triangles_t*)counters_buffer;
+
+	for (uint32_t edge_index = from_edge; edge_index < to_edge; edge_index += max_edges_in_buffer) {
+		uint32_t edges_in_buffer = to_edge - edge_index;
+		edges_in_buffer          = (edges_in_buffer < max_edges_in_buffer) ? edges_in_buffer : max_edges_in_buffer;
+		mram_read(&sorted_sample[edge_index], edges_buffer, edges_in_buffer * sizeof(edge_t));
+		mram_read(&edge_triangles[edge_index], counters_buffer, edges_in_buffer * sizeof(edge_triangles_t));
+
+		for (uint32_t i = 0; i < edges_in_buffer; i++) {
+			pairs_buffer[i] =
+			    (node_triangles_t){edges_buffer[i].v, counters_buffer[i].as_first + counters_buffer[i].as_last};
+		}
+
+		mram_write(pairs_buffer, &edge_triangles[edge_index], edges_in_buffer * sizeof(node_triangles_t));
+	}
+}
+
+void compact_node_triangles(__mram_ptr node_triangles_t* pairs, uint32_t nr_pairs,
+                            __mram_ptr node_triangles_t* compacted, void* wram_buffer_ptr) {
+	uint32_t          max_pairs_in_buffer = WRAM_BUFFER_SIZE / sizeof(node_triangles_t);
+	node_triangles_t* pairs_buffer        = (node_triangles_t*)wram_buffer_ptr;
+
+	while (true) {
+		// The pairs are read while holding the mutex, so that no more pairs are written than the pairs already read
+		mutex_lock(compact_pairs);
+		uint32_t read_offset   = global_pairs_read_offset;
+		uint32_t pairs_to_read = nr_pairs - read_offset;
+		pairs_to_read          = (pairs_to_read < max_pairs_in_buffer) ? pairs_to_read : max_pairs_in_buffer;
+		if (pairs_to_read == 0) {
+			mutex_unlock(compact_pairs);
+			break;
+		}
+		mram_read(&pairs[read_offset], pairs_buffer, pairs_to_read * sizeof(node_triangles_t));
+		global_pairs_read_offset += pairs_to_read;
+		mutex_unlock(compact_pairs);
+
+		uint32_t pairs_to_write = 0;
+		for (uint32_t i = 0; i < pairs_to_read; i++) {
+			if (pairs_buffer[i].triangles > 0) {
+				pairs_buffer[pairs_to_write++] = pairs_buffer[i];
+			}
+		}
+
+		if (pairs_to_write == 0) {
+			continue;
+		}
+
+		mutex_lock(compact_pairs);
+		uint32_t write_offset = global_pairs_write_offset;
+		global_pairs_write_offset += pairs_to_write;
+		mutex_unlock(compact_pairs);
+
+		mram_write(pairs_buffer, &compacted[write_offset], pairs_to_write * sizeof(node_triangles_t));
+	}
+}
+
+uint32_t get_nr_node_triangles() {
+	return global_pairs_write_offset;
+}
@@ -0,0 +1,50 @@
+#ifndef __LOCAL_COUNTS_H__
+#define __LOCAL_COUNTS_H__
+
+#include <attributes.h> // For __mram_ptr
+#include <stdint.h>     // Fixed size integers
+
+#include "../common/common.h"
+#include "locate_nodes.h"
+
+// Triangles of an edge (u, v) of the sorted sample. A triangle u < v < w is counted for u and v by its edge (u, v), the
+// one that finds it, and for w by its edge (u, w)
+typedef struct {
+	uint32_t as_first; // Triangles whose two lowest nodes are u and v
+	uint32_t as_last;  // Triangles whose lowest node is u and highest node is v
+} edge_triangles_t;
+
+// The local counts turn the counters of the edges into node_triangles_t pairs: one for each node location, with the
+// triangles of the edges starting with the node, and one for each edge, with the triangles of its second node. The
+// pairs without triangles are removed, and the others are moved to the start of the MRAM heap for the host
+
+// Use the counters starting at counters, one for each edge of the sorted sample. Each tasklet empties the counters of
+// its edges, from from_edge to to_edge (excluded)
+void init_local_counts(__mram_ptr edge_triangles_t* counters, uint32_t from_edge, uint32_t to_edge,
+                       void* wram_buffer_ptr);
+
+// Add the triangles of nr_edges consecutive edges of the sorted sample, starting at first_edge, to their counters. Any
+// tasklet can update any edge, so the tasklets gather the triangles in the WRAM and add them a few edges at a time
+void add_edge_triangles(uint32_t first_edge, edge_triangles_t* triangles, uint32_t nr_edges);
+
+// Replace the node locations handled by the tasklet with the triangles of their nodes as first nodes. The counters of
+// the edges must not be replaced yet
+void count_first_node_triangles(__mram_ptr edge_t* sorted_sample, uint32_t edges_in_sample, uint32_t num_locations,
+                                __mram_ptr node_loc_t* node_locations, void* wram_buffer_ptr);
+
+// Replace the counters of the edges from from_edge to to_edge (excluded) with the triangles of their second nodes
+void count_second_node_triangles(__mram_ptr edge_t* sorted_sample, uint32_t from_edge, uint32_t to_edge,
+                                 void* wram_buffer_ptr);
+
+// Move the nr_pairs pairs with triangles to compacted, placed before pairs. Each pair is read before the pairs written
+// can reach it
+void compact_node_triangles(__mram_ptr node_triangles_t* pairs, uint32_t nr_pairs,
+                            __mram_ptr node_triangles_t* compacted, void* wram_buffer_ptr);
+
+// Pairs moved by compact_node_triangles, once all the tasklets are done
+uint32_t get_nr_node_triangles();
+
+// Reset the offsets of the compaction before counting another sample
+void reset_local_counts();
+
+#endif /* __LOCAL_COUNTS_H__ */
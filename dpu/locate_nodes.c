@@ -17,6 +17,12 @@ uint32_t global_write_offset = 0;
 
 uint32_t remaining_tasklets = NR_TASKLETS;
 
+void reset_node_locations() {
+	global_read_offset  = 0;
+	global_write_offset = 0;
+	remaining_tasklets  = NR_TASKLETS;
+}
+
 uint32_t node_locations(__mram_ptr edge_t* sample, uint32_t edges_in_sample, __mram_ptr void* AFTER_SAMPLE_HEAP_POINTER,
                         void* wram_buffer_ptr) {
 	// Create a buffer in the WRAM of the sample to speed up research
@@ -25,6 +25,9 @@ void write_nodes_loc(uint32_t* nodes_loc_buffer_index, node_loc_t* nodes_loc_buf
 // Read new edges from the sample
 uint32_t virtually_read_from_sample(uint32_t edges_in_sample, uint32_t* edges_read);
 
+// Reset the offsets in the sample before counting another sample
+void reset_node_locations();
+
 // Debug function to know the information about the locations of the unique nodes
 void print_node_locations(uint32_t number_of_nodes, __mram_ptr void* AFTER_SAMPLE_HEAP_POINTER);
 
@@ -27,6 +27,10 @@ __mram uint64_t indices_off[NR_SPLITS][NR_TASKLETS];
 uint32_t current_split = 0;
 MUTEX_INIT(splits_mutex);
 
+void reset_sort() {
+	current_split = 0;
+}
+
 /*This is the main quicksort function. The sample will be moved from the current location to the top of the heap*/
 void sort_sample(uint32_t edges_in_sample, __mram_ptr edge_t* sample_from, edge_t* wram_buffer_ptr,
                  uint32_t max_node_id) {
@@ -6,7 +6,7 @@
 
 #include "../common/common.h"
 
-// Number (must be power of two multiple of tasklets) of sample splits to create.
+// Number (must be power of two) of sample splits to create.
 // More splits means more tasklet balance
 #ifndef NR_SPLITS
 #define NR_SPLITS 256
@@ -16,6 +16,9 @@
 void sort_sample(uint32_t edges_in_sample, __mram_ptr edge_t* sample_from, edge_t* wram_buffer_ptr,
                  uint32_t max_node_id);
 
+/*Reset the splits to order before sorting another sample*/
+void reset_sort();
+
 /*Performs a full step of quicksort using two caches that iterate from left and right*/
 uint32_t mram_partitioning(__mram_ptr edge_t* in, __mram_ptr edge_t* out, uint32_t num_edges, edge_t* left_wram_cache,
                            edge_t* right_wram_cache, edge_t pivot);
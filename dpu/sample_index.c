@@ -0,0 +1,120 @@
+#include <attributes.h> // For __dma_aligned
+#include <mram.h>       // Transfer data between WRAM and MRAM. Access MRAM
+#include <stdbool.h>    // Booleans
+#include <stdint.h>     // Fixed size integers
+
+#include "../common/common.h"
+#include "dpu_util.h"
+#include "sample_index.h"
+
+__mram_ptr uint32_t* sample_index;
+uint32_t             nr_index_slots;
+
+void create_sample_index(__mram_ptr uint32_t* index, uint32_t nr_slots) {
+	sample_index   = index;
+	nr_index_slots = nr_slots;
+}
+
+void clear_sample_index(uint32_t from_slot, uint32_t to_slot, uint32_t* wram_buffer_ptr) {
+	uint32_t max_slots_in_buffer = WRAM_BUFFER_SIZE / sizeof(uint32_t);
+	for (uint32_t i = 0; i < max_slots_in_buffer; i++) {
+		wram_buffer_ptr[i] = SAMPLE_INDEX_EMPTY;
+	}
+
+	for (uint32_t slot = from_slot; slot < to_slot; slot += max_slots_in_buffer) {
+		uint32_t slots_to_clear = (to_slot - slot < max_slots_in_buffer) ? to_slot - slot : max_slots_in_buffer;
+		mram_write(wram_buffer_ptr, &sample_index[slot], slots_to_clear * sizeof(uint32_t));
+	}
+}
+
+// The MRAM is accessed 8 bytes at a time, so the slots are read and written in pairs
+static uint32_t read_slot(uint32_t slot) {
+	__dma_aligned uint32_t pair[2];
+	mram_read(&sample_index[slot & ~1], pair, sizeof(pair));
+	return pair[slot & 1];
+}
+
+static void write_slot(uint32_t slot, uint32_t position) {
+	__dma_aligned uint32_t pair[2];
+	mram_read(&sample_index[slot & ~1], pair, sizeof(pair));
+	pair[slot & 1] = position;
+	mram_write(pair, &sample_index[slot & ~1], sizeof(pair));
+}
+
+static inline uint32_t get_home_slot(edge_t edge) {
+	uint32_t hash = (edge.u * 0x9E3779B1) ^ (edge.v * 0x85EBCA77);
+	hash ^= hash >> 15;
+	return hash % nr_index_slots;
+}
+
+static inline uint32_t next_slot(uint32_t slot) {
+	return (slot + 1 == nr_index_slots) ? 0 : slot + 1;
+}
+
+static edge_t read_sample_edge(__mram_ptr edge_t* sample, uint32_t position) {
+	__dma_aligned edge_t edge;
+	mram_read(&sample[position], &edge, sizeof(edge_t));
+	return edge;
+}
+
+void add_to_sample_index(edge_t edge, uint32_t position) {
+	// There are more slots than edges in the sample, so there is always an empty slot
+	uint32_t slot = get_home_slot(edge);
+	while (read_slot(slot) != SAMPLE_INDEX_EMPTY) {
+		slot = next_slot(slot);
+	}
+	write_slot(slot, position);
+}
+
+uint32_t find_in_sample_index(edge_t edge, __mram_ptr edge_t* sample) {
+	for (uint32_t slot = get_home_slot(edge);; slot = next_slot(slot)) {
+		uint32_t position = read_slot(slot);
+		if (position == SAMPLE_INDEX_EMPTY) {
+			return SAMPLE_INDEX_EMPTY;
+		}
+
+		edge_t sample_edge = read_sample_edge(sample, position);
+		if (sample_edge.u == edge.u && sample_edge.v == edge.v) {
+			return slot;
+		}
+	}
+}
+
+uint32_t find_position_in_sample_index(edge_t edge, uint32_t position) {
+	// The same edge can be in the sample more than once, the position tells them apart
+	uint32_t slot = get_home_slot(edge);
+	while (read_slot(slot) != position) {
+		slot = next_slot(slot);
+	}
+	return slot;
+}
+
+uint32_t get_sample_index_position(uint32_t slot) {
+	return read_slot(slot);
+}
+
+void set_sample_index_position(uint32_t slot, uint32_t position) {
+	write_slot(slot, position);
+}
+
+void remove_from_sample_index(uint32_t slot, __mram_ptr edge_t* sample) {
+	// The next edges of the run move back to the empty slot, unless their home slot is after it
+	uint32_t empty_slot = slot;
+	for (uint32_t current_slot = next_slot(slot);; current_slot = next_slot(current_slot)) {
+		uint32_t position = read_slot(current_slot);
+		if (position == SAMPLE_INDEX_EMPTY) {
+			break;
+		}
+
+		// The home slot is cyclically in (empty_slot, current_slot]: the edge cannot move before it
+		uint32_t home_slot   = get_home_slot(read_sample_edge(sample, position));
+		bool     is_in_place = (empty_slot <= current_slot)
+		                           ? (empty_slot < home_slot && home_slot <= current_slot)
+		                           : (empty_slot < home_slot || home_slot <= current_slot);
+		if (!is_in_place) {
+			write_slot(empty_slot, position);
+			empty_slot = current_slot;
+		}
+	}
+	write_slot(empty_slot, SAMPLE_INDEX_EMPTY);
+}
@@ -0,0 +1,37 @@
+#ifndef __SAMPLE_INDEX_H__
+#define __SAMPLE_INDEX_H__
+
+#include <attributes.h> // For __mram_ptr
+#include <stdint.h>     // Fixed size integers
+
+#include "../common/common.h"
+
+// Value of the empty slots
+#define SAMPLE_INDEX_EMPTY UINT32_MAX
+
+// Hash table in the MRAM with the position in the sample of each edge of the sample, used to find the deleted edges of
+// the fully dynamic graphs. It uses linear probing, and the slots after a removed edge are moved back, so that the
+// deletions do not leave tombstones. The slots are only accessed by a tasklet at a time
+
+// Use the nr_slots slots (an even number) starting at index. They must be emptied before being used
+void create_sample_index(__mram_ptr uint32_t* index, uint32_t nr_slots);
+
+// Empty the slots from from_slot to to_slot (excluded, both even) through the WRAM buffer
+void clear_sample_index(uint32_t from_slot, uint32_t to_slot, uint32_t* wram_buffer_ptr);
+
+// Add the edge at the given position of the sample
+void add_to_sample_index(edge_t edge, uint32_t position);
+
+// Returns the slot of the edge, or SAMPLE_INDEX_EMPTY if it is not in the sample
+uint32_t find_in_sample_index(edge_t edge, __mram_ptr edge_t* sample);
+
+// Returns the slot of the edge at the given position of the sample, which must be in the index
+uint32_t find_position_in_sample_index(edge_t edge, uint32_t position);
+
+uint32_t get_sample_index_position(uint32_t slot);
+void     set_sample_index_position(uint32_t slot, uint32_t position);
+
+// Remove the edge of the slot. The edges in the other slots must still be in the sample
+void remove_from_sample_index(uint32_t slot, __mram_ptr edge_t* sample);
+
+#endif /* __SAMPLE_INDEX_H__ */
@@ -12,20 +12,29 @@
 
 #include "../common/common.h"
 #include "dpu_util.h"
+#include "local_counts.h"
 #include "locate_nodes.h"
 #include "quicksort.h"
+#include "sample_index.h"
 #include "triangle_counter.h"
 
 // Variables set by the host
 __host dpu_arguments_t DPU_INPUT_ARGUMENTS;
 
 // When the execution code is 1, that means that the graph has been completely read,
-// the host has sent the value and the triangle counting can start
+// the host has sent the value and the triangle counting can start.
+// When the execution code is 2, the state of the DPU is reset, so that it can count another graph without being loaded.
+// When the execution code is 3, the triangles are counted like with 1, but the sample is kept for the next batches
 __host execution_config_t execution_config = {0, 0};
 
 // Variable that will be read by the host at the end
 __host uint64_t triangle_estimation;
 
+// With the local counts, pairs of node and triangles at the start of the MRAM heap, read by the host at the end. Their
+// triangles are multiplied by the scale, like the triangles of the estimation
+__host uint64_t nr_local_counts;
+__host double   local_counts_scale;
+
 // Current count of edges in the sample (limited by sample size)
 uint32_t edges_in_sample = 0;
 
@@ -73,8 +82,125 @@ MUTEX_INIT(insert_into_sample); // Virtual insertion
 uint32_t global_index_to_save_sample = 0;
 MUTEX_INIT(replace_in_sample);
 
+// Fully dynamic graphs (random pairing). A deleted edge leaves the sample, and the deletion is compensated by a next
+// insertion, which enters the sample with probability deletions_in_sample / (deletions_in_sample + deletions_outside).
+// The deletions are found with an index of the sample, placed before the sample
+uint32_t deletions_in_sample = 0; // Deletions of edges of the sample not compensated yet
+uint32_t deletions_outside   = 0; // Deletions of edges outside of the sample not compensated yet
+MUTEX_INIT(update_dynamic_sample);
+
+static void add_dynamic_edge(edge_t edge) {
+	mram_write(&edge, &sample[edges_in_sample], sizeof(edge_t));
+	add_to_sample_index(edge, edges_in_sample);
+	edges_in_sample++;
+}
+
+static void insert_dynamic_edge(edge_t edge) {
+	total_edges++;
+
+	uint32_t deletions = deletions_in_sample + deletions_outside;
+	if (deletions == 0) { // Reservoir sampling
+		if (edges_in_sample < DPU_INPUT_ARGUMENTS.sample_size) {
+			add_dynamic_edge(edge);
+			return;
+		}
+
+		float u_rand = (float)rand() / ((float)UINT_MAX + 1.0);
+		float thres  = ((float)DPU_INPUT_ARGUMENTS.sample_size) / total_edges;
+		if (u_rand < thres) {
+			uint32_t random_index = rand_range(0, DPU_INPUT_ARGUMENTS.sample_size - 1);
+
+			__dma_aligned edge_t replaced_edge;
+			mram_read(&sample[random_index], &replaced_edge, sizeof(edge_t));
+			remove_from_sample_index(find_position_in_sample_index(replaced_edge, random_index), sample);
+
+			mram_write(&edge, &sample[random_index], sizeof(edge_t));
+			add_to_sample_index(edge, random_index);
+		}
+	} else if (rand_range(1, deletions) <= deletions_in_sample) {
+		add_dynamic_edge(edge);
+		deletions_in_sample--;
+	} else {
+		deletions_outside--;
+	}
+}
+
+static void delete_dynamic_edge(edge_t edge) {
+	total_edges--;
+
+	uint32_t slot = find_in_sample_index(edge, sample);
+	if (slot == SAMPLE_INDEX_EMPTY) {
+		deletions_outside++;
+		return;
+	}
+
+	uint32_t position = get_sample_index_position(slot);
+	remove_from_sample_index(slot, sample);
+	deletions_in_sample++;
+
+	// The last edge of the sample takes the place of the deleted one
+	edges_in_sample--;
+	if (position != edges_in_sample) {
+		__dma_aligned edge_t last_edge;
+		mram_read(&sample[edges_in_sample], &last_edge, sizeof(edge_t));
+		set_sample_index_position(find_position_in_sample_index(last_edge, edges_in_sample), position);
+		mram_write(&last_edge, &sample[position], sizeof(edge_t));
+	}
+}
+
+// Every tasklet reads the whole batch, and handles only its own edges, so that an edge is deleted after it was inserted
+static void handle_dynamic_batch(edge_t* batch_buffer) {
+	uint32_t max_edges_in_batch_buffer = WRAM_BUFFER_SIZE / sizeof(edge_t);
+
+	for (uint32_t batch_index = 0; batch_index < edges_in_batch; batch_index += max_edges_in_batch_buffer) {
+		uint32_t edges_in_batch_buffer = edges_in_batch - batch_index;
+		edges_in_batch_buffer =
+		    (edges_in_batch_buffer < max_edges_in_batch_buffer) ? edges_in_batch_buffer : max_edges_in_batch_buffer;
+		mram_read(&batch[batch_index], batch_buffer, edges_in_batch_buffer * sizeof(edge_t));
+
+		for (uint32_t i = 0; i < edges_in_batch_buffer; i++) {
+			edge_t edge        = batch_buffer[i];
+			bool   is_deletion = edge.u & EDGE_DELETION_FLAG;
+			edge.u &= ~EDGE_DELETION_FLAG;
+
+			if ((edge.u ^ edge.v) % NR_TASKLETS != me()) {
+				continue;
+			}
+
+			mutex_lock(update_dynamic_sample);
+			if (is_deletion) {
+				delete_dynamic_edge(edge);
+			} else {
+				insert_dynamic_edge(edge);
+			}
+			mutex_unlock(update_dynamic_sample);
+		}
+	}
+}
+
 int main() {
 
+	if (execution_config.execution_code == 2) { // RESET OPERATIONS
+		// The next launch does the setup again, with the arguments of the next graph
+		if (me() == 0) {
+			edges_in_sample             = 0;
+			total_edges                 = 0;
+			is_sample_full              = false;
+			global_index_to_save_sample = 0;
+			deletions_in_sample         = 0;
+			deletions_outside           = 0;
+			triangle_estimation         = 0; // The DPUs without edges do not write it
+			nr_local_counts             = 0;
+			reset_node_locations();
+			reset_sort();
+			reset_triangle_counter();
+			reset_local_counts();
+
+			is_setup_done = false;
+		}
+		return 0;
+	}
+
 	if (!is_setup_done) {
 
 		// Make only one tasklet set up the variables for the entire DPU (and so all tasklets)
@@ -88,15 +214,29 @@ int main() {
 			sample = (__mram_ptr edge_t*)(64 * 1024 * 1024 - WRAM_BUFFER_SIZE -
 			                              DPU_INPUT_ARGUMENTS.sample_size * sizeof(edge_t));
 
-			// If Misra-Gries is used
+			// If the top frequent nodes are sent
 			if (DPU_INPUT_ARGUMENTS.t != 0) {
 				top_frequent_nodes = mem_alloc(DPU_INPUT_ARGUMENTS.t * sizeof(node_frequency_t));
 			}
+
+			// Two slots for each edge of the sample, so that the runs of linear probing are short
+			if (DPU_INPUT_ARGUMENTS.has_deletions) {
+				create_sample_index((__mram_ptr uint32_t*)sample - 2 * DPU_INPUT_ARGUMENTS.sample_size,
+				                    2 * DPU_INPUT_ARGUMENTS.sample_size);
+			}
 		}
 		barrier_wait(&sync_tasklets); // Wait for memory reset
 		tasklets_buffer_ptrs[me()] =
 		    mem_alloc(WRAM_BUFFER_SIZE); // Create the buffer in the WRAM for every tasklet. Generic void* pointer
 
+		// The tasklets empty the slots of the index together. Each part has an even number of slots
+		if (DPU_INPUT_ARGUMENTS.has_deletions) {
+			uint32_t slots_per_tasklet = DPU_INPUT_ARGUMENTS.sample_size / NR_TASKLETS * 2;
+			uint32_t to_slot           = (me() == NR_TASKLETS - 1) ? 2 * DPU_INPUT_ARGUMENTS.sample_size
+			                                                       : slots_per_tasklet * (me() + 1);
+			clear_sample_index(slots_per_tasklet * me(), to_slot, tasklets_buffer_ptrs[me()]);
+		}
+
 		is_setup_done = true;
 		return 0;
 	}
@@ -104,7 +244,9 @@ int main() {
 	// Locate the buffer in the WRAM for this tasklet each run
 	void* wram_buffer_ptr = tasklets_buffer_ptrs[me()];
 
-	if (execution_config.execution_code == 0) { // SAMPLE CREATION OPERATIONS
+	if (execution_config.execution_code == 0 && DPU_INPUT_ARGUMENTS.has_deletions) { // FULLY DYNAMIC SAMPLE
+		handle_dynamic_batch((edge_t*)wram_buffer_ptr);
+	} else if (execution_config.execution_code == 0) { // SAMPLE CREATION OPERATIONS
 
 		// Range handled by a tasklet
 		uint32_t handled_edges     = (uint32_t)edges_in_batch / NR_TASKLETS;
@@ -215,42 +357,68 @@ int main() {
 
 		uint32_t tasklet_id = me(); // Makes it easier to understand the code
 
-		// If Misra-Gries is used
-		if (DPU_INPUT_ARGUMENTS.t != 0) {
+		// A query counts the triangles of the sample and keeps it, so that more batches can be added to the sample
+		bool               is_query       = execution_config.execution_code == 3;
+		__mram_ptr edge_t* sample_to_sort = sample;
+
+		// The offsets of the previous query are reset. The other tasklets use them only after a barrier
+		if (is_query && tasklet_id == 0) {
+			reset_node_locations();
+			reset_sort();
+			reset_triangle_counter();
+			reset_local_counts();
+		}
 
-			// Split the workload equally among the tasklets
-			uint32_t edges_per_tasklet = edges_in_sample / NR_TASKLETS;
-			uint32_t from_edge         = edges_per_tasklet * tasklet_id;
-			uint32_t to_edge = (tasklet_id == NR_TASKLETS - 1) ? edges_in_sample : edges_per_tasklet * (tasklet_id + 1);
+		// Split the workload equally among the tasklets
+		uint32_t edges_per_tasklet = edges_in_sample / NR_TASKLETS;
+		uint32_t from_edge         = edges_per_tasklet * tasklet_id;
+		uint32_t to_edge = (tasklet_id == NR_TASKLETS - 1) ? edges_in_sample : edges_per_tasklet * (tasklet_id + 1);
 
-			// Transfer the most frequent nodes from the MRAM to the WRAM
+		// Transfer the most frequent nodes from the MRAM to the WRAM. They are at the start of the heap, where the copy
+		// of a query can overwrite them
+		if (DPU_INPUT_ARGUMENTS.t != 0) {
 			if (tasklet_id == 0) {
 				mram_read(top_frequent_nodes_MRAM, top_frequent_nodes,
 				          DPU_INPUT_ARGUMENTS.t * sizeof(node_frequency_t));
 			}
 			barrier_wait(&sync_tasklets);
+		}
+
+		// The partitioning of the sort moves the edges, and the positions of the edges are in the index of the fully
+		// dynamic samples. A query sorts a copy of the sample, placed after the sorted sample, where the node
+		// locations are written once the copy is sorted
+		if (is_query) {
+			sample_to_sort = (__mram_ptr edge_t*)DPU_MRAM_HEAP_POINTER + edges_in_sample;
+			copy_sample(&sample[from_edge], &sample_to_sort[from_edge], to_edge - from_edge, wram_buffer_ptr);
+			barrier_wait(&sync_tasklets);
+		}
 
-			frequent_nodes_remapping(sample, from_edge, to_edge, wram_buffer_ptr, nr_top_nodes, top_frequent_nodes,
-			                         execution_config.max_node_id);
+		// If the top frequent nodes are sent
+		if (DPU_INPUT_ARGUMENTS.t != 0) {
+			frequent_nodes_remapping(sample_to_sort, from_edge, to_edge, wram_buffer_ptr, nr_top_nodes,
+			                         top_frequent_nodes, execution_config.max_node_id);
 			barrier_wait(&sync_tasklets);
 		}
 
-		sort_sample(edges_in_sample, sample, wram_buffer_ptr, execution_config.max_node_id + DPU_INPUT_ARGUMENTS.t);
+		sort_sample(edges_in_sample, sample_to_sort, wram_buffer_ptr,
+		            execution_config.max_node_id + DPU_INPUT_ARGUMENTS.t);
 		barrier_wait(&sync_tasklets); // Wait for the sort to happen
 
-		// After the quicksort, some pointers change. Does not matter if set by all tasklets
-		sample                    = DPU_MRAM_HEAP_POINTER;
-		AFTER_SAMPLE_HEAP_POINTER = (__mram_ptr void*)sample + edges_in_sample * sizeof(edge_t);
+		// After the quicksort, the sorted sample is at the start of the heap. Does not matter if set by all tasklets
+		__mram_ptr edge_t* sorted_sample = DPU_MRAM_HEAP_POINTER;
+		AFTER_SAMPLE_HEAP_POINTER        = (__mram_ptr void*)sorted_sample + edges_in_sample * sizeof(edge_t);
 
 		// Each message will contain the local_unique_nodes
-		messages[tasklet_id] = node_locations(sample, edges_in_sample, AFTER_SAMPLE_HEAP_POINTER, wram_buffer_ptr);
+		messages[tasklet_id] =
+		    node_locations(sorted_sample, edges_in_sample, AFTER_SAMPLE_HEAP_POINTER, wram_buffer_ptr);
 
 		// Tree-based reduction to find the number of unique nodes
 		barrier_wait(&sync_tasklets);
 
 #pragma unroll
 		for (uint32_t offset = 1; offset < NR_TASKLETS; offset <<= 1) {
-			if ((tasklet_id & ((offset << 1) - 1)) == 0) {
+			// The number of tasklets may not be a power of two
+			if ((tasklet_id & ((offset << 1) - 1)) == 0 && tasklet_id + offset < NR_TASKLETS) {
 				// Add up the number of local unique nodes
 				messages[tasklet_id] += messages[tasklet_id + offset];
 			}
@@ -258,22 +426,38 @@ int main() {
 		}
 
 		// The first tasklet message will contain the number of unique nodes
-		messages[tasklet_id] =
-		    count_triangles(sample, edges_in_sample, messages[0], AFTER_SAMPLE_HEAP_POINTER, wram_buffer_ptr);
+		uint32_t num_locations = messages[0];
+
+		// The counters of the edges of the local counts are placed after the node locations
+		if (DPU_INPUT_ARGUMENTS.has_local_counts) {
+			init_local_counts((__mram_ptr edge_triangles_t*)AFTER_SAMPLE_HEAP_POINTER + num_locations, from_edge,
+			                  to_edge, wram_buffer_ptr);
+			barrier_wait(&sync_tasklets);
+		}
+
+		messages[tasklet_id] = count_triangles(sorted_sample, edges_in_sample, num_locations, AFTER_SAMPLE_HEAP_POINTER,
+		                                       wram_buffer_ptr, DPU_INPUT_ARGUMENTS.has_local_counts);
 
 		// Tree-based reduction to find the total number of triangles
 		barrier_wait(&sync_tasklets);
 
 #pragma unroll
 		for (uint32_t offset = 1; offset < NR_TASKLETS; offset <<= 1) {
-			if ((tasklet_id & ((offset << 1) - 1)) == 0) {
+			// The number of tasklets may not be a power of two
+			if ((tasklet_id & ((offset << 1) - 1)) == 0 && tasklet_id + offset < NR_TASKLETS) {
 				// Add up the number of local unique nodes
 				messages[tasklet_id] += messages[tasklet_id + offset];
 			}
 			barrier_wait(&sync_tasklets);
 		}
 
-		if (me() == 0) {
+		if (me() == 0 && DPU_INPUT_ARGUMENTS.has_deletions) {
+			// The sample is not full if edges were deleted
+			double p = get_random_pairing_probability(total_edges, deletions_in_sample + deletions_outside,
+			                                          DPU_INPUT_ARGUMENTS.sample_size, edges_in_sample);
+			triangle_estimation = (p > 0) ? (uint64_t)messages[0] / p : messages[0];
+			local_counts_scale  = (p > 0) ? 1 / p : 1;
+		} else if (me() == 0) {
 			if (edges_in_sample < total_edges) {
 				// Normalization of the result considering the substituted edges may have removed triangles
 				double p = ((float)DPU_INPUT_ARGUMENTS.sample_size / total_edges) *
@@ -282,8 +466,29 @@ int main() {
 
 				// The first tasklet message will contain the number of triangles counted by the tasklets
 				triangle_estimation = (uint64_t)messages[0] / p;
+				local_counts_scale  = 1 / p;
 			} else {
 				triangle_estimation = messages[0];
+				local_counts_scale  = 1;
+			}
+		}
+
+		// The counters of the edges become pairs of node and triangles, and the pairs of the node locations are
+		// followed by the pairs of the edges. They are compacted over the sorted sample, which is not needed anymore
+		if (DPU_INPUT_ARGUMENTS.has_local_counts) {
+			count_first_node_triangles(sorted_sample, edges_in_sample, num_locations, AFTER_SAMPLE_HEAP_POINTER,
+			                           wram_buffer_ptr);
+			barrier_wait(&sync_tasklets);
+
+			count_second_node_triangles(sorted_sample, from_edge, to_edge, wram_buffer_ptr);
+			barrier_wait(&sync_tasklets);
+
+			compact_node_triangles(AFTER_SAMPLE_HEAP_POINTER, num_locations + edges_in_sample,
+			                       (__mram_ptr node_triangles_t*)sorted_sample, wram_buffer_ptr);
+			barrier_wait(&sync_tasklets);
+
+			if (me() == 0) {
+				nr_local_counts = get_nr_node_triangles();
 			}
 		}
 	}
@@ -7,19 +7,51 @@
 
 #include "../common/common.h"
 #include "dpu_util.h"
+#include "local_counts.h"
 #include "locate_nodes.h"
 #include "triangle_counter.h"
 
 uint32_t global_sample_read_offset = 0;
 MUTEX_INIT(read_from_sample);
 
+void reset_triangle_counter() {
+	global_sample_read_offset = 0;
+}
+
+// Add the triangles gathered for the edges of the u buffer, the first one at start_index of the sample, to their
+// counters, and empty the buffer. Only the edges from the first to the last one with triangles are updated
+static void flush_u_edge_triangles(edge_triangles_t* u_edge_triangles, uint32_t max_edges, uint32_t start_index) {
+	uint32_t from = 0;
+	while (from < max_edges && u_edge_triangles[from].as_first == 0 && u_edge_triangles[from].as_last == 0) {
+		from++;
+	}
+	if (from == max_edges) {
+		return;
+	}
+
+	uint32_t to = max_edges;
+	while (u_edge_triangles[to - 1].as_first == 0 && u_edge_triangles[to - 1].as_last == 0) {
+		to--;
+	}
+
+	add_edge_triangles(start_index + from, &u_edge_triangles[from], to - from);
+	for (uint32_t i = from; i < to; i++) {
+		u_edge_triangles[i] = (edge_triangles_t){0, 0};
+	}
+}
+
 uint32_t count_triangles(__mram_ptr edge_t* sample, uint32_t edges_in_sample, uint32_t num_locations,
-                         __mram_ptr void* AFTER_SAMPLE_HEAP_POINTER, void* wram_buffer_ptr) {
+                         __mram_ptr void* AFTER_SAMPLE_HEAP_POINTER, void* wram_buffer_ptr, bool has_local_counts) {
 	uint32_t triangle_count = 0;
 
 	// Create a buffer in the WRAM to read more than one edge from the sample
-	// Better to read more single edges to consider in order to acquire the mutex less often
-	uint32_t max_edges_in_sample_buffer = (WRAM_BUFFER_SIZE - (WRAM_BUFFER_SIZE >> 2)) / sizeof(edge_t);
+	// Better to read more single edges to consider in order to acquire the mutex less often. With the local counts, the
+	// last eighth of the WRAM buffer is left for the triangles of the edges in the u buffer
+	uint32_t sample_buffer_size = WRAM_BUFFER_SIZE - (WRAM_BUFFER_SIZE >> 2);
+	if (has_local_counts) {
+		sample_buffer_size -= WRAM_BUFFER_SIZE >> 3;
+	}
+	uint32_t max_edges_in_sample_buffer = sample_buffer_size / sizeof(edge_t);
 	edge_t*  sample_buffer              = (edge_t*)wram_buffer_ptr;
 	uint32_t edges_to_read              = 0;
 
@@ -29,6 +61,16 @@ uint32_t count_triangles(__mram_ptr edge_t* sample, uint32_t edges_in_sample, ui
 	edge_t*  v_counting_sample_buffer =
 	    (edge_t*)wram_buffer_ptr + max_edges_in_sample_buffer + max_edges_in_counting_sample_buffer;
 
+	// The triangles of the edges in the u buffer are gathered here, and added to their counters in the MRAM only when
+	// the u buffer is replaced, instead of for every triangle
+	edge_triangles_t* u_edge_triangles =
+	    (edge_triangles_t*)(wram_buffer_ptr + WRAM_BUFFER_SIZE - (WRAM_BUFFER_SIZE >> 3));
+	if (has_local_counts) {
+		for (uint32_t i = 0; i < max_edges_in_counting_sample_buffer; i++) {
+			u_edge_triangles[i] = (edge_triangles_t){0, 0};
+		}
+	}
+
 	// After decreasing the size of the stack, there is more space for dynamic allocation
 	// Given a buffer of size N bytes, the cycles needed for the binary search without a buffer are log2(N/8) * (77 +
 	// 0.5 * 8), with a buffer (77 + 0.5 * N) A buffer gives better results with N between 24 and 960
@@ -97,11 +139,17 @@ uint32_t count_triangles(__mram_ptr edge_t* sample, uint32_t edges_in_sample, ui
 		uint32_t u_counting_sample_buffer_index = 0;
 		uint32_t v_counting_sample_buffer_index = 0;
 
+		uint32_t edge_triangle_count = 0; // Triangles found by the current edge, for the local counts
+
 		// Use the u edges that are already present in the buffer (wait for first load by looking at v)
 		if (start_index_v_counting_sample_buffer != 0 && u_sample_index >= start_index_u_counting_sample_buffer &&
 		    u_sample_index < start_index_u_counting_sample_buffer + max_edges_in_counting_sample_buffer) {
 			u_counting_sample_buffer_index = u_sample_index - start_index_u_counting_sample_buffer;
 		} else {
+			if (has_local_counts) {
+				flush_u_edge_triangles(u_edge_triangles, max_edges_in_counting_sample_buffer,
+				                       start_index_u_counting_sample_buffer);
+			}
 
 			// Use the edges that are already present in the WRAM
 			uint32_t u_edges_to_copy_from_sample_buffer;
@@ -155,6 +203,12 @@ uint32_t count_triangles(__mram_ptr edge_t* sample, uint32_t edges_in_sample, ui
 				// this
 				triangle_count++;
 
+				// The edge (u, w) counts the triangle for w. The edges after the sample are not part of it
+				if (has_local_counts && u_sample_index + u_sample_offset < edges_in_sample) {
+					edge_triangle_count++;
+					u_edge_triangles[u_counting_sample_buffer_index].as_last++;
+				}
+
 				u_sample_offset++;
 				v_sample_offset++;
 
@@ -174,6 +228,10 @@ uint32_t count_triangles(__mram_ptr edge_t* sample, uint32_t edges_in_sample, ui
 
 			// Retrieve new edges starting with u
 			if (u_counting_sample_buffer_index == max_edges_in_counting_sample_buffer) {
+				if (has_local_counts) {
+					flush_u_edge_triangles(u_edge_triangles, max_edges_in_counting_sample_buffer,
+					                       start_index_u_counting_sample_buffer);
+				}
 				mram_read(&sample[u_sample_index + u_sample_offset], u_counting_sample_buffer,
 				          max_edges_in_counting_sample_buffer * sizeof(edge_t));
 				start_index_u_counting_sample_buffer = u_sample_index + u_sample_offset;
@@ -188,6 +246,22 @@ uint32_t count_triangles(__mram_ptr edge_t* sample, uint32_t edges_in_sample, ui
 				v_counting_sample_buffer_index       = 0;
 			}
 		}
+
+		// The current edge counts its triangles for u and v, directly if it is not in the u buffer anymore
+		if (edge_triangle_count > 0) {
+			if (u_sample_index >= start_index_u_counting_sample_buffer &&
+			    u_sample_index < start_index_u_counting_sample_buffer + max_edges_in_counting_sample_buffer) {
+				u_edge_triangles[u_sample_index - start_index_u_counting_sample_buffer].as_first += edge_triangle_count;
+			} else {
+				edge_triangles_t current_edge_triangles = {edge_triangle_count, 0};
+				add_edge_triangles(u_sample_index, &current_edge_triangles, 1);
+			}
+		}
+	}
+
+	if (has_local_counts) {
+		flush_u_edge_triangles(u_edge_triangles, max_edges_in_counting_sample_buffer,
+		                       start_index_u_counting_sample_buffer);
 	}
 
 	return triangle_count;
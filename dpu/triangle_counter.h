@@ -7,9 +7,14 @@
 #include "dpu_util.h"
 #include "locate_nodes.h"
 
-// from and to are used to divide the workload between tasklets
+// from and to are used to divide the workload between tasklets. With has_local_counts, the triangles are also added to
+// the counters of the edges, see local_counts.h
 uint32_t count_triangles(__mram_ptr edge_t* sample, uint32_t edges_in_sample, uint32_t num_locations,
-                         __mram_ptr void* AFTER_SAMPLE_HEAP_POINTER, void* wram_buffer_ptr); // to is excluded
+                         __mram_ptr void* AFTER_SAMPLE_HEAP_POINTER, void* wram_buffer_ptr,
+                         bool has_local_counts); // to is excluded
+
+// Reset the offset in the sample before counting the triangles of another sample
+void reset_triangle_counter();
 
 // Iterative binary search for finding the informations about a node (possible because the nodes info are ordered)
 node_loc_t get_location_info(uint32_t unique_nodes, uint32_t node_id, __mram_ptr void* AFTER_SAMPLE_HEAP_POINTER,
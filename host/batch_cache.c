@@ -0,0 +1,360 @@
+#include <dpu.h>
+#include <errno.h> // Check existing directories
+#include <fcntl.h>
+#include <limits.h> // Max path length
+#include <stdatomic.h>
+#include <stdbool.h>  // Booleans
+#include <stdint.h>   // Fixed size integers
+#include <stdio.h>    // Print
+#include <stdlib.h>   // Various
+#include <string.h>   // Compare the magic string
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // Create directories
+#include <unistd.h>
+
+#include "../common/common.h"
+#include "batch_cache.h"
+#include "host_util.h"
+
+// 64-bit FNV-1a
+static uint64_t hash_bytes(uint64_t hash, const void* data, uint64_t size) {
+	for (uint64_t i = 0; i < size; i++) {
+		hash = (hash ^ ((const uint8_t*)data)[i]) * 0x100000001B3;
+	}
+	return hash;
+}
+
+uint64_t get_batch_cache_key(const struct stat* file_stat, int32_t seed, uint32_t colors, float p,
+                             uint64_t dedup_memory, bool degree_order, uint32_t coloring_candidates,
+                             uint32_t nr_estimators, bool has_deletions, uint32_t k, uint32_t t) {
+
+	// The fields are copied one by one, so that padding bytes do not change the key
+	uint64_t fields[] = {file_stat->st_dev,
+	                     file_stat->st_ino,
+	                     file_stat->st_size,
+	                     file_stat->st_mtim.tv_sec,
+	                     file_stat->st_mtim.tv_nsec,
+	                     (uint32_t)seed,
+	                     colors,
+	                     (uint64_t)(p * 1e9), // Same key for the same value given with -p
+	                     dedup_memory,
+	                     degree_order,
+	                     coloring_candidates,
+	                     nr_estimators,
+	                     has_deletions,
+	                     k,
+	                     (k > 0) ? t : 0, // No top frequent nodes are searched without counters
+	                     BATCH_CACHE_VERSION};
+
+	return hash_bytes(0xCBF29CE484222325, fields, sizeof(fields));
+}
+
+static void check_path_length(int path_length) {
+	if (path_length >= PATH_MAX) {
+		printf("The path of the cache directory is too long.\n");
+		exit(1);
+	}
+}
+
+static void get_triplet_file_path(char* triplet_path, const char* entry_path, uint32_t triplet_id) {
+	check_path_length(snprintf(triplet_path, PATH_MAX, "%s/triplet_%u.bin", entry_path, triplet_id));
+}
+
+static void get_meta_file_path(char* meta_path, const char* entry_path) {
+	check_path_length(snprintf(meta_path, PATH_MAX, "%s/meta", entry_path));
+}
+
+// The entry cannot be used: release what open_batch_cache allocated for it, and move it out of the way, so that the
+// run creates it again in a new temporary directory and can rename it to the path of the entry. Returns false, a miss
+static bool reject_batch_cache(batch_cache_t* cache, uint32_t nr_mapped_triplets, const char* reason) {
+	if (cache->edges != NULL) {
+		for (uint32_t triplet_id = 0; triplet_id < nr_mapped_triplets; triplet_id++) {
+			munmap(cache->edges[triplet_id], cache->mapping_size);
+		}
+	}
+	free(cache->edges);
+	free(cache->edge_counts);
+	free(cache->top_nodes);
+	cache->edges       = NULL;
+	cache->edge_counts = NULL;
+	cache->top_nodes   = NULL;
+
+	// Kept for inspection, like the entries left by concurrent runs
+	char invalid_path[PATH_MAX];
+	check_path_length(snprintf(invalid_path, PATH_MAX, "%s.invalid.%d", cache->path, getpid()));
+	if (rename(cache->path, invalid_path) == 0) {
+		printf("Warning: %s in the cache entry %s. It is moved to %s and created again.\n", reason, cache->path,
+		       invalid_path);
+	} else {
+		printf("Warning: %s in the cache entry %s, which cannot be moved aside. It is not used.\n", reason,
+		       cache->path);
+	}
+
+	return false;
+}
+
+bool open_batch_cache(batch_cache_t* cache, const char* cache_dir, uint64_t key, uint32_t nr_triplets) {
+
+	check_path_length(snprintf(cache->path, PATH_MAX, "%s/%016lx", cache_dir, key));
+	cache->key         = key;
+	cache->nr_triplets = nr_triplets;
+	cache->fds         = NULL;
+	cache->edges       = NULL;
+	cache->edge_counts = NULL;
+	cache->top_nodes   = NULL;
+
+	// The meta file is written last, so the entry is complete if it exists
+	char meta_path[PATH_MAX];
+	get_meta_file_path(meta_path, cache->path);
+	FILE* meta_file = fopen(meta_path, "rb");
+	if (meta_file == NULL) {
+		return false;
+	}
+
+	bool is_valid = fread(&cache->header, sizeof(cache->header), 1, meta_file) == 1 &&
+	                memcmp(cache->header.magic, BATCH_CACHE_MAGIC, sizeof(cache->header.magic)) == 0 &&
+	                cache->header.version == BATCH_CACHE_VERSION && cache->header.key == key &&
+	                cache->header.nr_triplets == nr_triplets;
+
+	// The size of the file is checked before the arrays are allocated, so that a corrupted number of top nodes is
+	// never allocated
+	struct stat meta_stat;
+	uint64_t    meta_size = sizeof(cache->header) + nr_triplets * sizeof(uint64_t) +
+	                     (uint64_t)cache->header.nr_top_nodes * sizeof(node_frequency_t);
+	is_valid = is_valid && fstat(fileno(meta_file), &meta_stat) == 0 && (uint64_t)meta_stat.st_size == meta_size;
+
+	if (is_valid) {
+		uint64_t nr_top_nodes = cache->header.nr_top_nodes;
+		cache->edge_counts    = (uint64_t*)malloc(nr_triplets * sizeof(uint64_t));
+		cache->top_nodes      = (node_frequency_t*)malloc(nr_top_nodes * sizeof(node_frequency_t));
+		is_valid = fread(cache->edge_counts, sizeof(uint64_t), nr_triplets, meta_file) == nr_triplets &&
+		           fread(cache->top_nodes, sizeof(node_frequency_t), nr_top_nodes, meta_file) == nr_top_nodes;
+	}
+	fclose(meta_file);
+	if (!is_valid) {
+		return reject_batch_cache(cache, 0, "Invalid meta file");
+	}
+
+	uint64_t max_edge_count = 0;
+	for (uint32_t triplet_id = 0; triplet_id < nr_triplets; triplet_id++) {
+		max_edge_count = (cache->edge_counts[triplet_id] > max_edge_count) ? cache->edge_counts[triplet_id]
+		                                                                    : max_edge_count;
+	}
+
+	// The padding is anonymous memory reserved after the file, so it does not need to exist in the file
+	cache->mapping_size = (max_edge_count + MAX_EDGES_PER_TRANSFER) * sizeof(edge_t);
+	cache->edges        = (edge_t**)malloc(nr_triplets * sizeof(edge_t*));
+
+	for (uint32_t triplet_id = 0; triplet_id < nr_triplets; triplet_id++) {
+		cache->edges[triplet_id] = (edge_t*)mmap(0, cache->mapping_size, PROT_READ,
+		                                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (cache->edges[triplet_id] == MAP_FAILED) {
+			return reject_batch_cache(cache, triplet_id, "Cannot reserve the memory of a triplet");
+		}
+
+		uint64_t file_size = cache->edge_counts[triplet_id] * sizeof(edge_t);
+		if (file_size == 0) {
+			continue;
+		}
+
+		char triplet_path[PATH_MAX];
+		get_triplet_file_path(triplet_path, cache->path, triplet_id);
+
+		struct stat triplet_stat;
+		int         triplet_fd = open(triplet_path, O_RDONLY);
+		if (triplet_fd < 0 || fstat(triplet_fd, &triplet_stat) != 0 || (uint64_t)triplet_stat.st_size != file_size) {
+			if (triplet_fd >= 0) {
+				close(triplet_fd);
+			}
+			return reject_batch_cache(cache, triplet_id + 1, "Invalid triplet file");
+		}
+
+		void* triplet_edges = mmap(cache->edges[triplet_id], file_size, PROT_READ,
+		                           MAP_PRIVATE | MAP_FIXED | MAP_POPULATE, triplet_fd, 0);
+		close(triplet_fd);
+		if (triplet_edges == MAP_FAILED) {
+			return reject_batch_cache(cache, triplet_id + 1, "Cannot map a triplet file");
+		}
+	}
+
+	cache->empty_batch = (edge_t*)mmap(0, MAX_EDGES_PER_TRANSFER * sizeof(edge_t), PROT_READ,
+	                                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (cache->empty_batch == MAP_FAILED) {
+		return reject_batch_cache(cache, nr_triplets, "Cannot reserve the memory of the empty batch");
+	}
+
+	return true;
+}
+
+void create_batch_cache(batch_cache_t* cache, const char* cache_dir, uint64_t key, uint32_t nr_triplets) {
+
+	check_path_length(snprintf(cache->path, PATH_MAX, "%s/%016lx", cache_dir, key));
+	// Concurrent runs do not collide
+	check_path_length(snprintf(cache->tmp_path, PATH_MAX, "%s.tmp.%d", cache->path, getpid()));
+	cache->key         = key;
+	cache->nr_triplets = nr_triplets;
+	cache->edges       = NULL;
+	cache->edge_counts = NULL; // Counted when the entry is committed
+
+	if ((mkdir(cache_dir, 0755) != 0 && errno != EEXIST) || mkdir(cache->tmp_path, 0755) != 0) {
+		printf("Cannot create the cache directory %s.\n", cache->tmp_path);
+		exit(1);
+	}
+
+	cache->fds           = (int*)malloc(nr_triplets * sizeof(int));
+	cache->written_edges = (atomic_uint_fast64_t*)malloc(nr_triplets * sizeof(atomic_uint_fast64_t));
+	for (uint32_t triplet_id = 0; triplet_id < nr_triplets; triplet_id++) {
+		char triplet_path[PATH_MAX];
+		get_triplet_file_path(triplet_path, cache->tmp_path, triplet_id);
+
+		cache->fds[triplet_id] = open(triplet_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (cache->fds[triplet_id] < 0) {
+			printf("Cannot create the cache file %s.\n", triplet_path);
+			exit(1);
+		}
+		atomic_init(&cache->written_edges[triplet_id], 0);
+	}
+}
+
+void append_to_batch_cache(batch_cache_t* cache, uint32_t triplet_id, const edge_t* edges, uint64_t nr_edges) {
+
+	if (nr_edges == 0) {
+		return;
+	}
+
+	// Reserve a range of the file, so that the threads can write at the same time
+	uint64_t first_edge =
+	    atomic_fetch_add_explicit(&cache->written_edges[triplet_id], nr_edges, memory_order_relaxed);
+
+	const char* data   = (const char*)edges;
+	uint64_t    size   = nr_edges * sizeof(edge_t);
+	uint64_t    offset = first_edge * sizeof(edge_t);
+	while (size > 0) {
+		ssize_t bytes_written = pwrite(cache->fds[triplet_id], data, size, offset);
+		if (bytes_written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			printf("Cannot write the cache file of triplet %u.\n", triplet_id);
+			exit(1);
+		}
+		data += bytes_written;
+		offset += bytes_written;
+		size -= bytes_written;
+	}
+}
+
+void commit_batch_cache(batch_cache_t* cache, uint32_t max_node_id, uint64_t total_edges, uint64_t edges_kept,
+                        const node_frequency_t* top_nodes, uint32_t nr_top_nodes) {
+
+	cache->header = (batch_cache_header_t){.version      = BATCH_CACHE_VERSION,
+	                                       .nr_triplets  = cache->nr_triplets,
+	                                       .key          = cache->key,
+	                                       .total_edges  = total_edges,
+	                                       .edges_kept   = edges_kept,
+	                                       .max_node_id  = max_node_id,
+	                                       .nr_top_nodes = nr_top_nodes};
+	memcpy(cache->header.magic, BATCH_CACHE_MAGIC, sizeof(cache->header.magic));
+
+	cache->edge_counts = (uint64_t*)malloc(cache->nr_triplets * sizeof(uint64_t));
+	for (uint32_t triplet_id = 0; triplet_id < cache->nr_triplets; triplet_id++) {
+		cache->edge_counts[triplet_id] = atomic_load(&cache->written_edges[triplet_id]);
+		close(cache->fds[triplet_id]);
+	}
+
+	char meta_path[PATH_MAX];
+	get_meta_file_path(meta_path, cache->tmp_path);
+	FILE* meta_file = fopen(meta_path, "wb");
+	if (meta_file == NULL) {
+		printf("Cannot create the cache file %s.\n", meta_path);
+		exit(1);
+	}
+	fwrite(&cache->header, sizeof(cache->header), 1, meta_file);
+	fwrite(cache->edge_counts, sizeof(uint64_t), cache->nr_triplets, meta_file);
+	fwrite(top_nodes, sizeof(node_frequency_t), nr_top_nodes, meta_file);
+	if (fclose(meta_file) != 0) {
+		printf("Cannot write the cache file %s.\n", meta_path);
+		exit(1);
+	}
+
+	// The entry becomes visible at once. If another run created it in the meantime, keep that one
+	if (rename(cache->tmp_path, cache->path) != 0) {
+		printf("The cache entry %s already exists. The new entry is left in %s.\n", cache->path, cache->tmp_path);
+	}
+}
+
+void discard_batch_cache(batch_cache_t* cache) {
+	for (uint32_t triplet_id = 0; triplet_id < cache->nr_triplets; triplet_id++) {
+		close(cache->fds[triplet_id]);
+
+		char triplet_path[PATH_MAX];
+		get_triplet_file_path(triplet_path, cache->tmp_path, triplet_id);
+		unlink(triplet_path);
+	}
+	rmdir(cache->tmp_path);
+}
+
+void send_batch_cache(batch_cache_t* cache, struct dpu_set_t dpu_set, uint32_t first_triplet, uint32_t nr_triplets) {
+
+	// The DPUs receive the triplets from first_triplet on
+	uint64_t* edge_counts = &cache->edge_counts[first_triplet];
+	edge_t**  edges       = &cache->edges[first_triplet];
+
+	uint64_t max_edge_count = 0;
+	for (uint32_t triplet_id = 0; triplet_id < nr_triplets; triplet_id++) {
+		max_edge_count = (edge_counts[triplet_id] > max_edge_count) ? edge_counts[triplet_id] : max_edge_count;
+	}
+
+	// The last element is always 0, for the DPUs beyond the triplets
+	uint64_t* edges_in_batch = (uint64_t*)malloc((nr_triplets + 1) * sizeof(uint64_t));
+
+	for (uint64_t batch_offset = 0; batch_offset < max_edge_count; batch_offset += MAX_EDGES_PER_TRANSFER) {
+
+		uint64_t edges_to_send = max_edge_count - batch_offset;
+		edges_to_send          = (edges_to_send > MAX_EDGES_PER_TRANSFER) ? MAX_EDGES_PER_TRANSFER : edges_to_send;
+
+		// Wait for all the DPUs to finish the previous batch
+		DPU_ASSERT(dpu_sync(dpu_set));
+
+		// The edges are transferred directly from the mapped files. The DPUs beyond the triplets receive no edges
+		memset(edges_in_batch, 0, (nr_triplets + 1) * sizeof(uint64_t));
+		uint32_t         dpu_id;
+		struct dpu_set_t dpu;
+		DPU_FOREACH(dpu_set, dpu, dpu_id) {
+			if (dpu_id < nr_triplets && batch_offset < edge_counts[dpu_id]) {
+				uint64_t remaining_edges = edge_counts[dpu_id] - batch_offset;
+				edges_in_batch[dpu_id]   = (remaining_edges > edges_to_send) ? edges_to_send : remaining_edges;
+				DPU_ASSERT(dpu_prepare_xfer(dpu, &edges[dpu_id][batch_offset]));
+			} else {
+				DPU_ASSERT(dpu_prepare_xfer(dpu, cache->empty_batch));
+			}
+		}
+		DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_TO_DPU, DPU_MRAM_HEAP_POINTER_NAME, 0,
+		                         edges_to_send * sizeof(edge_t), DPU_XFER_DEFAULT));
+
+		DPU_FOREACH(dpu_set, dpu, dpu_id) {
+			DPU_ASSERT(dpu_prepare_xfer(dpu, &edges_in_batch[(dpu_id < nr_triplets) ? dpu_id : nr_triplets]));
+		}
+		DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_TO_DPU, "edges_in_batch", 0, sizeof(uint64_t), DPU_XFER_DEFAULT));
+
+		DPU_ASSERT(dpu_launch(dpu_set, DPU_ASYNCHRONOUS));
+	}
+
+	free(edges_in_batch);
+}
+
+void close_batch_cache(batch_cache_t* cache) {
+	if (cache->edges != NULL) {
+		for (uint32_t triplet_id = 0; triplet_id < cache->nr_triplets; triplet_id++) {
+			munmap(cache->edges[triplet_id], cache->mapping_size);
+		}
+		munmap(cache->empty_batch, MAX_EDGES_PER_TRANSFER * sizeof(edge_t));
+		free(cache->edges);
+		free(cache->top_nodes);
+	}
+	if (cache->fds != NULL) {
+		free(cache->fds);
+		free(cache->written_edges);
+	}
+	free(cache->edge_counts);
+}
@@ -0,0 +1,84 @@
+#ifndef __BATCH_CACHE_H__
+#define __BATCH_CACHE_H__
+
+#include <dpu.h>
+#include <limits.h> // Max path length
+#include <stdatomic.h>
+#include <stdbool.h>  // Booleans
+#include <stdint.h>   // Fixed size integers
+#include <sys/stat.h> // Identify the graph file
+
+#include "../common/common.h"
+
+// A cache entry is a directory named after the key, containing a meta file and one file for each triplet with the
+// edges sent to its DPU, in the same layout used in the MRAM, so that they can be transferred directly
+#define BATCH_CACHE_MAGIC   "PIMTCCHE"
+#define BATCH_CACHE_VERSION 2
+
+// Start of the meta file. It is followed by the number of edges of each triplet (uint64_t) and by the top frequent
+// nodes (node_frequency_t)
+typedef struct {
+	char     magic[8];
+	uint32_t version;
+	uint32_t nr_triplets;
+	uint64_t key;
+	uint64_t total_edges; // Edges in the graph, without the dropped duplicates and self-loops
+	uint64_t edges_kept;  // Edges kept by the uniform sampling
+	uint32_t max_node_id;
+	uint32_t nr_top_nodes;
+} batch_cache_header_t;
+
+typedef struct {
+	char     path[PATH_MAX];     // Directory of the cache entry
+	char     tmp_path[PATH_MAX]; // Directory written during the run, renamed to path when complete
+	uint64_t key;
+	uint32_t nr_triplets;
+
+	batch_cache_header_t header;
+	uint64_t*            edge_counts; // For each triplet
+	node_frequency_t*    top_nodes;
+
+	// Writing. Threads reserve a range of the file of a triplet, then write it without locks
+	int*                  fds;
+	atomic_uint_fast64_t* written_edges;
+
+	// Reading. The mappings have MAX_EDGES_PER_TRANSFER edges of padding after the edges of the triplet, so that
+	// transfers of the same size to all the DPUs never read outside of them
+	edge_t** edges;
+	uint64_t mapping_size;
+	edge_t*  empty_batch; // Sent to the DPUs that have no more edges
+} batch_cache_t;
+
+// Key of the cache entry. It depends on the identity of the graph file (device, inode, size and modification time)
+// and on everything that changes the edges sent to each DPU. The size of the set of -u is part of it, since a set
+// that fills up lets duplicates through. The top frequent nodes of the entry are the ones of the Space-Saving counters
+// of the run that created it, which depend on k and t, so they are part of it too
+uint64_t get_batch_cache_key(const struct stat* file_stat, int32_t seed, uint32_t colors, float p,
+                             uint64_t dedup_memory, bool degree_order, uint32_t coloring_candidates,
+                             uint32_t nr_estimators, bool has_deletions, uint32_t k, uint32_t t);
+
+// Map the cache entry with the given key. Returns false if there is no complete entry. An invalid entry is a miss: it
+// is moved aside with a warning, so that the run creates it again
+bool open_batch_cache(batch_cache_t* cache, const char* cache_dir, uint64_t key, uint32_t nr_triplets);
+
+// Start a new cache entry, filled by append_to_batch_cache during the run
+void create_batch_cache(batch_cache_t* cache, const char* cache_dir, uint64_t key, uint32_t nr_triplets);
+
+// Add the edges of a batch to the file of a triplet. Can be called by all the threads
+void append_to_batch_cache(batch_cache_t* cache, uint32_t triplet_id, const edge_t* edges, uint64_t nr_edges);
+
+// Write the meta file and make the entry visible to the next runs
+void commit_batch_cache(batch_cache_t* cache, uint32_t max_node_id, uint64_t total_edges, uint64_t edges_kept,
+                        const node_frequency_t* top_nodes, uint32_t nr_top_nodes);
+
+// Close and remove the files of an entry that is not committed, since the run failed
+void discard_batch_cache(batch_cache_t* cache);
+
+// Send the cached edges of nr_triplets triplets, from first_triplet on, to the DPUs, in transfers of at most
+// MAX_EDGES_PER_TRANSFER edges per DPU
+void send_batch_cache(batch_cache_t* cache, struct dpu_set_t dpu_set, uint32_t first_triplet, uint32_t nr_triplets);
+
+// Unmap or close the files of the cache entry
+void close_batch_cache(batch_cache_t* cache);
+
+#endif /* __BATCH_CACHE_H__ */
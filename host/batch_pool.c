@@ -0,0 +1,104 @@
+#include <pthread.h>  // Mutexes and condition variables
+#include <stdint.h>   // Fixed size integers
+#include <stdio.h>    // Print
+#include <stdlib.h>   // Various
+#include <sys/mman.h> // mmap
+
+#include "../common/common.h"
+#include "batch_pool.h"
+
+uint64_t get_chunk_edges(uint64_t memory, uint32_t nr_batches) {
+	uint64_t max_chunk_edges = memory / sizeof(edge_t) / ((uint64_t)nr_batches * CHUNKS_PER_BATCH);
+
+	uint64_t chunk_edges = MIN_CHUNK_EDGES;
+	while (chunk_edges * 2 <= max_chunk_edges && chunk_edges * 2 <= MAX_CHUNK_EDGES) {
+		chunk_edges *= 2;
+	}
+
+	// Fewer than CHUNKS_PER_BATCH chunks are fine, as long as each batch can have one chunk being filled and one being
+	// sent
+	if (memory / (chunk_edges * sizeof(edge_t)) < 2 * (uint64_t)nr_batches) {
+		return 0;
+	}
+	return chunk_edges;
+}
+
+void create_batch_pool(batch_pool_t* pool, uint64_t memory, uint64_t chunk_edges) {
+	pool->chunk_edges = chunk_edges;
+	pool->nr_chunks   = memory / (chunk_edges * sizeof(edge_t));
+
+	// No MAP_POPULATE: the pages are allocated when the chunks are used, so small graphs do not touch all the pool
+	pool->edges = (edge_t*)mmap(0, pool->nr_chunks * chunk_edges * sizeof(edge_t), PROT_READ | PROT_WRITE,
+	                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (pool->edges == MAP_FAILED) {
+		printf("Cannot allocate the memory for the batches.\n");
+		exit(1);
+	}
+
+	pool->next        = (uint32_t*)malloc(pool->nr_chunks * sizeof(uint32_t));
+	pool->free_chunks = (uint32_t*)malloc(pool->nr_chunks * sizeof(uint32_t));
+	for (uint32_t i = 0; i < pool->nr_chunks; i++) {
+		pool->free_chunks[i] = pool->nr_chunks - 1 - i; // The first chunks are used first
+	}
+	pool->nr_free_chunks = pool->nr_chunks;
+
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->chunk_released, NULL);
+
+	pool->empty_chunk = (edge_t*)mmap(0, chunk_edges * sizeof(edge_t), PROT_READ,
+	                                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (pool->empty_chunk == MAP_FAILED) {
+		printf("Cannot allocate the memory for the batches.\n");
+		exit(1);
+	}
+}
+
+void delete_batch_pool(batch_pool_t* pool) {
+	munmap(pool->edges, pool->nr_chunks * pool->chunk_edges * sizeof(edge_t));
+	munmap(pool->empty_chunk, pool->chunk_edges * sizeof(edge_t));
+	free(pool->next);
+	free(pool->free_chunks);
+
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_cond_destroy(&pool->chunk_released);
+}
+
+uint32_t try_take_chunk(batch_pool_t* pool) {
+	uint32_t chunk = BATCH_POOL_NONE;
+
+	pthread_mutex_lock(&pool->mutex);
+	if (pool->nr_free_chunks > 0) {
+		chunk = pool->free_chunks[--pool->nr_free_chunks];
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return chunk;
+}
+
+uint32_t take_chunk(batch_pool_t* pool) {
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->nr_free_chunks == 0) {
+		pthread_cond_wait(&pool->chunk_released, &pool->mutex);
+	}
+	uint32_t chunk = pool->free_chunks[--pool->nr_free_chunks];
+	pthread_mutex_unlock(&pool->mutex);
+
+	return chunk;
+}
+
+uint32_t get_nr_free_chunks(batch_pool_t* pool) {
+	pthread_mutex_lock(&pool->mutex);
+	uint32_t nr_free_chunks = pool->nr_free_chunks;
+	pthread_mutex_unlock(&pool->mutex);
+
+	return nr_free_chunks;
+}
+
+void release_chunks(batch_pool_t* pool, uint32_t first_chunk) {
+	pthread_mutex_lock(&pool->mutex);
+	for (uint32_t chunk = first_chunk; chunk != BATCH_POOL_NONE; chunk = pool->next[chunk]) {
+		pool->free_chunks[pool->nr_free_chunks++] = chunk;
+	}
+	pthread_cond_broadcast(&pool->chunk_released);
+	pthread_mutex_unlock(&pool->mutex);
+}
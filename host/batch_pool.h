@@ -0,0 +1,73 @@
+#ifndef __BATCH_POOL_H__
+#define __BATCH_POOL_H__
+
+#include <pthread.h> // Mutexes and condition variables
+#include <stdint.h>  // Fixed size integers
+
+#include "../common/common.h"
+
+// Marks the end of a chain of chunks
+#define BATCH_POOL_NONE UINT32_MAX
+
+// Memory used for the batches if no memory budget is given. No more than 90% of the free memory is used
+#ifndef DEFAULT_BATCH_MEMORY
+#define DEFAULT_BATCH_MEMORY (4UL * 1024 * 1024 * 1024)
+#endif
+
+// Limits of the number of edges in each chunk. The chunks are powers of two between them
+#ifndef MIN_CHUNK_EDGES
+#define MIN_CHUNK_EDGES 1024
+#endif
+#ifndef MAX_CHUNK_EDGES
+#define MAX_CHUNK_EDGES (64 * 1024)
+#endif
+
+// Chunks in the pool for each batch, if the memory allows chunks of at least MIN_CHUNK_EDGES edges
+#ifndef CHUNKS_PER_BATCH
+#define CHUNKS_PER_BATCH 4
+#endif
+
+// Fixed-size chunks of edges shared by all the threads. The batch of each DPU is a chain of chunks, which are given
+// back to the pool once the DPUs are done with them. The memory used by the batches is fixed at
+// creation, and the pages of a chunk are only allocated when it is first used
+typedef struct {
+	edge_t*   edges;       // All the chunks, in a single mapping
+	uint64_t  chunk_edges; // Power of two
+	uint32_t  nr_chunks;
+	uint32_t* next; // Next chunk of the chain of each chunk
+
+	// Stack of free chunks, the chunks given back last are reused first while they are still in the cache
+	uint32_t*       free_chunks;
+	uint32_t        nr_free_chunks;
+	pthread_mutex_t mutex;
+	pthread_cond_t  chunk_released;
+
+	edge_t* empty_chunk; // Sent to the DPUs with fewer chunks than the others
+} batch_pool_t;
+
+// Size of the chunks that gives about CHUNKS_PER_BATCH chunks to each batch with the given memory.
+// Returns 0 if the memory cannot hold two chunks of MIN_CHUNK_EDGES edges for each batch
+uint64_t get_chunk_edges(uint64_t memory, uint32_t nr_batches);
+
+// Split the memory into chunks of chunk_edges edges
+void create_batch_pool(batch_pool_t* pool, uint64_t memory, uint64_t chunk_edges);
+
+void delete_batch_pool(batch_pool_t* pool);
+
+static inline edge_t* get_chunk(const batch_pool_t* pool, uint32_t chunk) {
+	return &pool->edges[chunk * pool->chunk_edges];
+}
+
+// Take a free chunk. Returns BATCH_POOL_NONE if all the chunks are used
+uint32_t try_take_chunk(batch_pool_t* pool);
+
+// Take a free chunk, waiting for the other threads to give back their chunks if all the chunks are used
+uint32_t take_chunk(batch_pool_t* pool);
+
+// Number of chunks that can be taken without waiting
+uint32_t get_nr_free_chunks(batch_pool_t* pool);
+
+// Give back a chain of chunks, linked with next and ending with BATCH_POOL_NONE
+void release_chunks(batch_pool_t* pool, uint32_t first_chunk);
+
+#endif /* __BATCH_POOL_H__ */
@@ -0,0 +1,35 @@
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+#include <stdio.h>   // Print
+#include <string.h>  // Compare the magic string
+
+#include "../common/common.h"
+#include "binary_graph.h"
+
+bool is_binary_graph(const char* mmaped_file, uint64_t file_size) {
+	return file_size >= sizeof(binary_graph_header_t) &&
+	       memcmp(mmaped_file, BINARY_GRAPH_MAGIC, sizeof(((binary_graph_header_t*)0)->magic)) == 0;
+}
+
+bool read_binary_graph_header(const char* mmaped_file, uint64_t file_size, binary_graph_header_t* header, char* error,
+                              size_t error_size) {
+	memcpy(header, mmaped_file, sizeof(binary_graph_header_t));
+
+	if (header->version != BINARY_GRAPH_VERSION) {
+		snprintf(error, error_size, "Unsupported binary graph version %u (expected %u).", header->version,
+		         BINARY_GRAPH_VERSION);
+		return false;
+	}
+
+	// Compared by division, since the number of edges of a corrupted header can overflow the size of the edges
+	if (header->nr_edges > (file_size - sizeof(binary_graph_header_t)) / sizeof(edge_t)) {
+		snprintf(error, error_size, "Binary graph is truncated: %lu edges declared in the header.", header->nr_edges);
+		return false;
+	}
+
+	return true;
+}
+
+const edge_t* binary_graph_edges(const char* mmaped_file) {
+	return (const edge_t*)(mmaped_file + sizeof(binary_graph_header_t));
+}
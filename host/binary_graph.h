@@ -0,0 +1,38 @@
+#ifndef __BINARY_GRAPH_H__
+#define __BINARY_GRAPH_H__
+
+#include <stdbool.h> // Booleans
+#include <stddef.h>  // Sizes
+#include <stdint.h>  // Fixed size integers
+
+#include "../common/common.h"
+
+// Binary edge list: a header followed by header.nr_edges packed edge_t
+#define BINARY_GRAPH_MAGIC   "PIMTCBIN"
+#define BINARY_GRAPH_VERSION 1
+
+// Flags in the header
+#define BINARY_GRAPH_NORMALIZED 0x1 // Every edge already has u < v
+
+// 32 bytes, so that the edges after the header are aligned to 8 bytes
+typedef struct {
+	char     magic[8];
+	uint32_t version;
+	uint32_t flags;
+	uint64_t nr_edges;
+	uint32_t max_node_id;
+	uint32_t padding;
+} binary_graph_header_t;
+
+// Returns if the mmapped file starts with the binary graph magic string
+bool is_binary_graph(const char* mmaped_file, uint64_t file_size);
+
+// Read the header of a binary graph. Returns false and writes the error (error_size chars) if the version or the size
+// of the file are not valid
+bool read_binary_graph_header(const char* mmaped_file, uint64_t file_size, binary_graph_header_t* header, char* error,
+                              size_t error_size);
+
+// Returns a pointer to the first edge of a binary graph
+const edge_t* binary_graph_edges(const char* mmaped_file);
+
+#endif /* __BINARY_GRAPH_H__ */
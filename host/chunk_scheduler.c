@@ -0,0 +1,98 @@
+#include <stdatomic.h>
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+#include <stdlib.h>  // Various
+
+#include "chunk_scheduler.h"
+#include "coo_parser.h"
+
+// Assign the same number of consecutive chunks to each thread
+static void create_queues(chunk_scheduler_t* scheduler, uint32_t nr_threads) {
+	scheduler->nr_queues = nr_threads;
+	scheduler->queues    = (chunk_queue_t*)aligned_alloc(alignof(chunk_queue_t), nr_threads * sizeof(chunk_queue_t));
+
+	uint64_t chunks_per_thread = scheduler->nr_chunks / nr_threads;
+	uint64_t remaining_chunks  = scheduler->nr_chunks % nr_threads;
+
+	uint64_t first_chunk = 0;
+	for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+		uint64_t nr_thread_chunks = chunks_per_thread + (th_id < remaining_chunks ? 1 : 0);
+
+		atomic_init(&scheduler->queues[th_id].next_chunk, first_chunk);
+		scheduler->queues[th_id].end_chunk = first_chunk + nr_thread_chunks;
+
+		first_chunk += nr_thread_chunks;
+	}
+}
+
+void create_file_chunk_scheduler(chunk_scheduler_t* scheduler, const char* mmaped_file, uint64_t file_size,
+                                 uint32_t nr_threads) {
+
+	uint64_t max_chunks  = file_size / INPUT_CHUNK_SIZE + 1;
+	scheduler->chunks    = (input_chunk_t*)malloc(max_chunks * sizeof(input_chunk_t));
+	scheduler->nr_chunks = 0;
+
+	// Each chunk ends after the first newline found after INPUT_CHUNK_SIZE chars, so no line is split
+	uint64_t from_char = 0;
+	while (from_char < file_size) {
+		uint64_t to_char = from_char + INPUT_CHUNK_SIZE;
+
+		if (to_char >= file_size) {
+			to_char = file_size;
+		} else {
+			to_char = find_next_newline(mmaped_file, to_char - 1, file_size) + 1;
+			to_char = (to_char > file_size) ? file_size : to_char;
+		}
+
+		scheduler->chunks[scheduler->nr_chunks++] = (input_chunk_t){from_char, to_char};
+		from_char                                 = to_char;
+	}
+
+	create_queues(scheduler, nr_threads);
+}
+
+void create_edges_chunk_scheduler(chunk_scheduler_t* scheduler, uint64_t nr_edges, uint32_t nr_threads) {
+
+	scheduler->nr_chunks = (nr_edges + INPUT_CHUNK_EDGES - 1) / INPUT_CHUNK_EDGES;
+	scheduler->chunks    = (input_chunk_t*)malloc((scheduler->nr_chunks + 1) * sizeof(input_chunk_t));
+
+	for (uint64_t i = 0; i < scheduler->nr_chunks; i++) {
+		uint64_t to_edge     = (i + 1) * INPUT_CHUNK_EDGES;
+		scheduler->chunks[i] = (input_chunk_t){i * INPUT_CHUNK_EDGES, (to_edge > nr_edges) ? nr_edges : to_edge};
+	}
+
+	create_queues(scheduler, nr_threads);
+}
+
+void reset_chunk_scheduler(chunk_scheduler_t* scheduler) {
+	for (uint32_t th_id = 0; th_id < scheduler->nr_queues; th_id++) {
+		uint64_t first_chunk = (th_id == 0) ? 0 : scheduler->queues[th_id - 1].end_chunk;
+		atomic_store(&scheduler->queues[th_id].next_chunk, first_chunk);
+	}
+}
+
+void delete_chunk_scheduler(chunk_scheduler_t* scheduler) {
+	free(scheduler->chunks);
+	free(scheduler->queues);
+}
+
+bool get_next_chunk(chunk_scheduler_t* scheduler, uint32_t th_id, input_chunk_t* chunk) {
+
+	// Start from the own queue, then try to steal from the following threads.
+	// The index can go past the end of a queue when threads compete for its last chunks, that is harmless
+	for (uint32_t i = 0; i < scheduler->nr_queues; i++) {
+		chunk_queue_t* queue = &scheduler->queues[(th_id + i) % scheduler->nr_queues];
+
+		if (atomic_load_explicit(&queue->next_chunk, memory_order_relaxed) >= queue->end_chunk) {
+			continue; // Do not touch the cache line of empty queues
+		}
+
+		uint64_t chunk_index = atomic_fetch_add_explicit(&queue->next_chunk, 1, memory_order_relaxed);
+		if (chunk_index < queue->end_chunk) {
+			*chunk = scheduler->chunks[chunk_index];
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,55 @@
+#ifndef __CHUNK_SCHEDULER_H__
+#define __CHUNK_SCHEDULER_H__
+
+#include <stdalign.h> // Align the queues to cache lines
+#include <stdatomic.h>
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+
+// Approximate size of each chunk of a COO file. The chunks always end after a newline
+#ifndef INPUT_CHUNK_SIZE
+#define INPUT_CHUNK_SIZE (1024 * 1024)
+#endif
+
+// Number of edges in each chunk of a binary file
+#ifndef INPUT_CHUNK_EDGES
+#define INPUT_CHUNK_EDGES (128 * 1024)
+#endif
+
+// Section of the input handled at once by a thread. Chars for COO files, edge indexes for binary files
+typedef struct {
+	uint64_t from;
+	uint64_t to; // Not included
+} input_chunk_t;
+
+// Contiguous range of chunks initially assigned to a thread. Other threads steal from it when they run out of chunks
+typedef struct {
+	alignas(64) atomic_uint_fast64_t next_chunk; // Own cache line, it is modified by different threads
+	uint64_t end_chunk;                          // Not included
+} chunk_queue_t;
+
+typedef struct {
+	input_chunk_t* chunks;
+	uint64_t       nr_chunks;
+
+	chunk_queue_t* queues; // One for each thread
+	uint32_t       nr_queues;
+} chunk_scheduler_t;
+
+// Split a COO file into chunks of about INPUT_CHUNK_SIZE chars, starting after a newline
+void create_file_chunk_scheduler(chunk_scheduler_t* scheduler, const char* mmaped_file, uint64_t file_size,
+                                 uint32_t nr_threads);
+
+// Split a binary file into chunks of INPUT_CHUNK_EDGES edges
+void create_edges_chunk_scheduler(chunk_scheduler_t* scheduler, uint64_t nr_edges, uint32_t nr_threads);
+
+// Give back all the chunks to the threads, to read the input again. No thread can be using the scheduler
+void reset_chunk_scheduler(chunk_scheduler_t* scheduler);
+
+void delete_chunk_scheduler(chunk_scheduler_t* scheduler);
+
+// Take the next chunk of the thread, or steal one from the other threads. Lock-free.
+// Returns false if all the chunks have been taken
+bool get_next_chunk(chunk_scheduler_t* scheduler, uint32_t th_id, input_chunk_t* chunk);
+
+#endif /* __CHUNK_SCHEDULER_H__ */
@@ -0,0 +1,221 @@
+#include <stdbool.h> // Booleans
+#include <stddef.h>  // NULL
+#include <stdint.h>  // Fixed size integers
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h> // SIMD intrinsics
+#endif
+
+#include "../common/common.h"
+#include "coo_parser.h"
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+// Bit i of each mask refers to the i-th char of the block
+typedef struct {
+	uint32_t newlines;
+	uint32_t digits;
+	uint32_t spaces; // Spaces, tabs and carriage returns
+} block_masks_t;
+
+static inline block_masks_t classify_block(const char* block) {
+#if defined(__AVX2__)
+	__m256i data = _mm256_loadu_si256((const __m256i*)block);
+
+	// Unsigned (c - '0') <= 9 if and only if c is a digit
+	__m256i shifted  = _mm256_sub_epi8(data, _mm256_set1_epi8('0'));
+	__m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(9)), shifted);
+
+	__m256i is_space = _mm256_or_si256(_mm256_cmpeq_epi8(data, _mm256_set1_epi8(' ')),
+	                                   _mm256_or_si256(_mm256_cmpeq_epi8(data, _mm256_set1_epi8('\t')),
+	                                                   _mm256_cmpeq_epi8(data, _mm256_set1_epi8('\r'))));
+
+	return (block_masks_t){
+	    .newlines = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, _mm256_set1_epi8('\n'))),
+	    .digits   = (uint32_t)_mm256_movemask_epi8(is_digit),
+	    .spaces   = (uint32_t)_mm256_movemask_epi8(is_space),
+	};
+#else
+	__m128i data = _mm_loadu_si128((const __m128i*)block);
+
+	// Unsigned (c - '0') <= 9 if and only if c is a digit
+	__m128i shifted  = _mm_sub_epi8(data, _mm_set1_epi8('0'));
+	__m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(9)), shifted);
+
+	__m128i is_space =
+	    _mm_or_si128(_mm_cmpeq_epi8(data, _mm_set1_epi8(' ')),
+	                 _mm_or_si128(_mm_cmpeq_epi8(data, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(data, _mm_set1_epi8('\r'))));
+
+	return (block_masks_t){
+	    .newlines = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(data, _mm_set1_epi8('\n'))),
+	    .digits   = (uint32_t)_mm_movemask_epi8(is_digit),
+	    .spaces   = (uint32_t)_mm_movemask_epi8(is_space),
+	};
+#endif
+}
+
+static inline uint32_t newline_mask(const char* block) {
+#if defined(__AVX2__)
+	__m256i data = _mm256_loadu_si256((const __m256i*)block);
+	return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, _mm256_set1_epi8('\n')));
+#else
+	__m128i data = _mm_loadu_si128((const __m128i*)block);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(data, _mm_set1_epi8('\n')));
+#endif
+}
+#endif
+
+// The number of digits is known, so there is no need to check for the end of the string like strtoul
+static inline uint32_t digits_to_uint(const char* digits, uint32_t nr_digits) {
+	uint32_t value = 0;
+	for (uint32_t i = 0; i < nr_digits; i++) {
+		value = value * 10 + (uint32_t)(digits[i] - '0');
+	}
+	return value;
+}
+
+static inline bool is_digit(char c) {
+	return (unsigned char)(c - '0') <= 9;
+}
+
+static inline bool is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+uint64_t find_next_newline(const char* file, uint64_t pos, uint64_t file_size) {
+#if defined(__AVX2__) || defined(__SSE4_2__)
+	// Never read outside the file, the end of the mapping may be the end of a page
+	for (; pos + PARSER_BLOCK_SIZE <= file_size; pos += PARSER_BLOCK_SIZE) {
+		uint32_t newlines = newline_mask(&file[pos]);
+		if (newlines != 0) {
+			return pos + __builtin_ctz(newlines);
+		}
+	}
+#endif
+	for (; pos < file_size; pos++) {
+		if (file[pos] == '\n') {
+			return pos;
+		}
+	}
+	return file_size;
+}
+
+// Used for the last bytes of the file and for lines longer than a block. The timestamp is the third number, if only
+// spaces are between it and the nodes
+static uint64_t parse_coo_line_scalar(const char* file, uint64_t pos, uint64_t file_size, edge_t* edge,
+                                      bool* is_valid, bool* is_deletion, uint64_t* timestamp, bool* has_timestamp) {
+	uint64_t numbers[3]    = {0, 0, 0};
+	uint32_t numbers_found = 0;
+	bool     valid         = true;
+	bool     is_timestamp  = true; // No other char after the nodes yet
+
+	*is_deletion = false;
+	while (pos < file_size && file[pos] != '\n') {
+
+		// A deletion has a '-' just before the first node
+		if (numbers_found == 0 && !*is_deletion && file[pos] == '-' && pos + 1 < file_size && is_digit(file[pos + 1])) {
+			*is_deletion = true;
+			pos++;
+			continue;
+		}
+
+		if (is_digit(file[pos])) {
+			uint64_t value = 0;
+			for (; pos < file_size && is_digit(file[pos]); pos++) {
+				value = value * 10 + (uint64_t)(file[pos] - '0');
+			}
+
+			if (numbers_found < 3) {
+				numbers[numbers_found] = value;
+			}
+			numbers_found++;
+			continue;
+		}
+
+		// Only spaces are allowed before and between the two nodes
+		if (numbers_found < 2 && !is_space(file[pos])) {
+			valid = false;
+		} else if (numbers_found == 2 && !is_space(file[pos])) {
+			is_timestamp = false;
+		}
+		pos++;
+	}
+
+	*is_valid = valid && numbers_found >= 2;
+	*edge     = (edge_t){(uint32_t)numbers[0], (uint32_t)numbers[1]};
+	if (timestamp != NULL) {
+		*has_timestamp = is_timestamp && numbers_found >= 3;
+		*timestamp     = numbers[2];
+	}
+
+	return (pos < file_size) ? pos + 1 : file_size; // Skip the '\n'
+}
+
+uint64_t parse_coo_update(const char* file, uint64_t pos, uint64_t file_size, edge_t* edge, bool* is_valid,
+                          bool* is_deletion) {
+#if defined(__AVX2__) || defined(__SSE4_2__)
+	// A line with two 32-bit node ids usually fits in a single block
+	if (pos + PARSER_BLOCK_SIZE <= file_size) {
+		block_masks_t masks = classify_block(&file[pos]);
+
+		if (masks.newlines != 0) {
+			uint32_t line_end  = __builtin_ctz(masks.newlines);
+			uint32_t line_bits = ((uint32_t)1 << line_end) - 1; // line_end is lower than 32
+			uint32_t digits    = masks.digits & line_bits;
+			uint32_t spaces    = masks.spaces & line_bits;
+
+			*is_valid    = false;
+			*is_deletion = false;
+			if (digits != 0) {
+				// First node: first run of digits, preceded only by spaces
+				uint32_t start_u = __builtin_ctz(digits);
+				uint32_t end_u   = start_u + __builtin_ctz(~(digits >> start_u)); // The newline is not a digit
+
+				// Second node: second run of digits, separated from the first only by spaces
+				uint32_t    other_digits = digits & ~(((uint32_t)1 << end_u) - 1);
+				uint32_t    before_u     = (((uint32_t)1 << start_u) - 1) & ~spaces;
+				const char* line         = &file[pos];
+
+				// A deletion has a '-' just before the first node
+				if (start_u > 0 && before_u == ((uint32_t)1 << (start_u - 1)) && line[start_u - 1] == '-') {
+					*is_deletion = true;
+					before_u     = 0;
+				}
+
+				if (other_digits != 0 && before_u == 0) {
+					uint32_t start_v = __builtin_ctz(other_digits);
+					uint32_t end_v   = start_v + __builtin_ctz(~(other_digits >> start_v));
+					uint32_t between = (((uint32_t)1 << start_v) - 1) & ~(((uint32_t)1 << end_u) - 1);
+
+					if ((between & ~spaces) == 0) {
+						*edge     = (edge_t){digits_to_uint(&line[start_u], end_u - start_u),
+						                     digits_to_uint(&line[start_v], end_v - start_v)};
+						*is_valid = true;
+					}
+				}
+			}
+
+			return pos + line_end + 1; // Skip the '\n'
+		}
+	}
+#endif
+	return parse_coo_line_scalar(file, pos, file_size, edge, is_valid, is_deletion, NULL, NULL);
+}
+
+uint64_t parse_coo_line(const char* file, uint64_t pos, uint64_t file_size, edge_t* edge, bool* is_valid) {
+	bool is_deletion;
+	pos = parse_coo_update(file, pos, file_size, edge, is_valid, &is_deletion);
+
+	// The deletions are not edges of the graph
+	*is_valid = *is_valid && !is_deletion;
+	return pos;
+}
+
+uint64_t parse_timed_coo_line(const char* file, uint64_t pos, uint64_t file_size, edge_t* edge, bool* is_valid,
+                              uint64_t* timestamp) {
+	// The lines with a timestamp rarely fit in a block
+	bool is_deletion, has_timestamp;
+	pos = parse_coo_line_scalar(file, pos, file_size, edge, is_valid, &is_deletion, timestamp, &has_timestamp);
+
+	*is_valid = *is_valid && !is_deletion && has_timestamp;
+	return pos;
+}
@@ -0,0 +1,36 @@
+#ifndef __COO_PARSER_H__
+#define __COO_PARSER_H__
+
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+
+#include "../common/common.h"
+
+// Number of bytes classified at once while looking for newlines and digits
+#if defined(__AVX2__)
+#define PARSER_BLOCK_SIZE 32
+#elif defined(__SSE4_2__)
+#define PARSER_BLOCK_SIZE 16
+#else
+#define PARSER_BLOCK_SIZE 8
+#endif
+
+// Returns the position of the first '\n' starting from pos (included), or file_size if there is none
+uint64_t find_next_newline(const char* file, uint64_t pos, uint64_t file_size);
+
+// Parse the line starting at pos directly from the (mmapped) file, without copying it.
+// A valid line contains two unsigned integers separated by spaces or tabs, anything after them is ignored.
+// Returns the position of the first char of the next line. is_valid is false if the line does not contain an edge
+uint64_t parse_coo_line(const char* file, uint64_t pos, uint64_t file_size, edge_t* edge, bool* is_valid);
+
+// Same as parse_coo_line, but the lines of the fully dynamic graphs whose first node is preceded by '-' ("-u v") are
+// valid, and they are deletions of the edge
+uint64_t parse_coo_update(const char* file, uint64_t pos, uint64_t file_size, edge_t* edge, bool* is_valid,
+                          bool* is_deletion);
+
+// Same as parse_coo_line, but the line must also have a timestamp: an unsigned integer after the two nodes, separated
+// from them only by spaces. The lines without a timestamp are not valid
+uint64_t parse_timed_coo_line(const char* file, uint64_t pos, uint64_t file_size, edge_t* edge, bool* is_valid,
+                              uint64_t* timestamp);
+
+#endif /* __COO_PARSER_H__ */
@@ -0,0 +1,1347 @@
+#include <dpu.h>    // Create DPU set
+#include <limits.h> // Max path length
+#include <stdio.h>  // Print
+
+// Handle file
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <math.h>     // floor and ceil
+#include <pthread.h>  // Threads
+#include <stdarg.h>   // Print the progress
+#include <stdbool.h>  // Booleans
+#include <stdint.h>   // Known size integers
+#include <stdlib.h>   // Various
+#include <string.h>   // Compare strings
+#include <sys/time.h> // Measure execution time
+
+#include "../common/common.h"
+#include "batch_cache.h"
+#include "batch_pool.h"
+#include "binary_graph.h"
+#include "chunk_scheduler.h"
+#include "count_job.h"
+#include "degree_order.h"
+#include "dpu_sender.h"
+#include "edge_set.h"
+#include "ensemble.h"
+#include "handle_edges_parallel.h"
+#include "host_util.h"
+#include "local_counts.h"
+#include "routing.h"
+#include "stream_reader.h"
+
+// Default seed, different in each run. It is not taken from rand(), whose state belongs to the programs using the
+// library. The time and the pid are mixed as in splitmix64, so that the seeds of close runs are not close
+static int32_t get_default_seed() {
+	struct timeval now;
+	gettimeofday(&now, 0);
+
+	uint64_t x = ((uint64_t)now.tv_sec * 1000000 + now.tv_usec) ^ ((uint64_t)getpid() << 40);
+	x          = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+	x          = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+	return (int32_t)((x ^ (x >> 31)) & INT32_MAX);
+}
+
+void init_count_job(count_job_t* job) {
+	*job = (count_job_t){
+	    .seed                = get_default_seed(),
+	    .sample_size         = MAX_SAMPLE_SIZE,
+	    .p                   = 1,
+	    .k                   = 0,
+	    .t                   = 5,
+	    .colors              = 0,
+	    .filename            = "",
+	    .memory_budget       = 0,
+	    .nr_threads          = sysconf(_SC_NPROCESSORS_ONLN),
+	    .dedup_memory        = 0,
+	    .cache_dir           = NULL,
+	    .degree_order        = false,
+	    .coloring_candidates = 1,
+	    .nr_estimators       = 1,
+	    .is_incremental      = false,
+	    .has_deletions       = false,
+	    .window_size         = 0,
+	    .is_time_window      = false,
+	    .window_period       = 0,
+	    .local_counts_path   = NULL,
+	    .edges               = NULL,
+	    .nr_edges            = 0,
+	    .is_quiet            = false,
+	};
+}
+
+bool set_count_job_option(count_job_t* job, char option, char* value, char* error) {
+	switch (option) {
+		case 's':
+		case 'S':
+			job->seed = atoi(value);
+			break;
+
+		case 'M':
+		case 'm':
+			job->sample_size = atoi(value);
+			break;
+
+		case 'p':
+		case 'P':
+			job->p = atof(value);
+			break;
+
+		case 'k':
+		case 'K':
+			job->k = atoi(value);
+			break;
+
+		case 't':
+		case 'T':
+			job->t = atoi(value);
+			break;
+
+		case 'c':
+		case 'C':
+			job->colors = atoi(value);
+			break;
+
+		case 'f':
+		case 'F':
+			job->filename = value;
+			break;
+
+		case 'b':
+		case 'B':
+			job->memory_budget = (uint64_t)atol(value) * 1024 * 1024; // Given in MB
+			break;
+
+		case 'n':
+		case 'N':
+			job->nr_threads = atoi(value);
+			break;
+
+		case 'u':
+		case 'U':
+			job->dedup_memory = (uint64_t)atol(value) * 1024 * 1024; // Given in MB
+			break;
+
+		case 'x':
+		case 'X':
+			job->cache_dir = value;
+			break;
+
+		case 'g':
+		case 'G':
+			job->coloring_candidates = atoi(value);
+			break;
+
+		case 'e':
+		case 'E':
+			job->nr_estimators = atoi(value);
+			break;
+
+		case 'i':
+		case 'I':
+			job->is_incremental = atoi(value) != 0;
+			break;
+
+		case 'r':
+		case 'R':
+			job->has_deletions = atoi(value) != 0;
+			break;
+
+		case 'w':
+		case 'W': {
+			// A number of edges, or of time units with the suffix s
+			char* unit;
+			job->window_size    = strtoull(value, &unit, 10);
+			job->is_time_window = strcmp(unit, "s") == 0;
+			if (unit == value || (*unit != '\0' && !job->is_time_window)) {
+				snprintf(error, COUNT_JOB_ERROR_SIZE, "Invalid window: %s", value);
+				return false;
+			}
+			break;
+		}
+
+		case 'q':
+		case 'Q':
+			job->window_period = strtoull(value, NULL, 10); // In the unit of the window
+			break;
+
+		case 'v':
+		case 'V':
+			job->local_counts_path = value;
+			break;
+
+		case 'o':
+		case 'O':
+			if (strcmp(value, "degree") == 0) {
+				job->degree_order = true;
+			} else if (strcmp(value, "none") == 0) {
+				job->degree_order = false;
+			} else {
+				snprintf(error, COUNT_JOB_ERROR_SIZE, "Invalid node ordering: %s", value);
+				return false;
+			}
+			break;
+
+		default:
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "Wrong argument: -%c", option);
+			return false;
+	}
+
+	return true;
+}
+
+uint32_t get_count_job_triplets(const count_job_t* job) {
+	// Number of triplets created given the colors. binom(c+2, 3)
+	uint32_t triplets_created = round((1.0 / 6) * job->colors * (job->colors + 1) * (job->colors + 2));
+
+	// The triplets of each estimator are numbered after the ones of the previous estimators
+	return triplets_created * job->nr_estimators;
+}
+
+bool check_count_job(count_job_t* job, uint32_t nr_dpus, char* error) {
+	if (job->sample_size > MAX_SAMPLE_SIZE) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "Sample size is too big. Max possible value is %d.", MAX_SAMPLE_SIZE);
+		return false;
+	}
+
+	// The sample of the incremental jobs is kept while a sorted copy of it is counted
+	if (job->is_incremental && job->sample_size > MAX_INCREMENTAL_SAMPLE_SIZE) {
+		job->sample_size = MAX_INCREMENTAL_SAMPLE_SIZE;
+	}
+
+	// The DPUs also keep an index of the sample, to find the deleted edges. The edges leaving a window are deleted
+	bool is_dynamic = job->has_deletions || job->window_size > 0;
+	if (is_dynamic && job->sample_size > MAX_DYNAMIC_SAMPLE_SIZE) {
+		job->sample_size = MAX_DYNAMIC_SAMPLE_SIZE;
+	}
+
+	// The counters of the edges of the local counts are placed after the node locations
+	if (job->local_counts_path != NULL && job->sample_size > MAX_LOCAL_COUNTS_SAMPLE_SIZE) {
+		job->sample_size = MAX_LOCAL_COUNTS_SAMPLE_SIZE;
+	}
+
+	if (job->p < 0 || job->p > 1) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "Invalid percentage of kept edges.");
+		return false;
+	}
+
+	if (job->k != 0 && job->t > job->k) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "Invalid parameters for Space-Saving.");
+		return false;
+	}
+
+	// The nodes are already ordered by their exact degree, there is nothing to remap in the DPUs
+	if (job->degree_order && job->k != 0) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "The top frequent nodes (-k) cannot be used with the degree ordering.");
+		return false;
+	}
+
+	// The windows are counted before the end of the graph, when the top frequent nodes are not known
+	if (job->window_size > 0) {
+		job->k = 0;
+	}
+
+	if (job->window_size > 0 && job->window_period == 0) {
+		job->window_period = job->window_size;
+	}
+
+	if (job->k == 0) {
+		job->t = 0;
+	}
+
+	if (job->colors == 0) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "Invalid number of colors.");
+		return false;
+	}
+
+	uint32_t triplets_created = round((1.0 / 6) * job->colors * (job->colors + 1) * (job->colors + 2));
+	if (triplets_created > MAX_ROUTING_TRIPLETS) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "Too many colors. No more than %d triplets can be used.",
+		         MAX_ROUTING_TRIPLETS);
+		return false;
+	}
+
+	if (job->nr_estimators == 0) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "Invalid number of estimators.");
+		return false;
+	}
+
+	if (job->coloring_candidates == 0) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "Invalid number of candidate colorings.");
+		return false;
+	}
+
+	if (job->nr_threads == 0) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "Invalid number of threads.");
+		return false;
+	}
+
+	// The next jobs add their edges to the samples of all the triplets, so they must stay on the DPUs
+	if (job->is_incremental && get_count_job_triplets(job) > nr_dpus) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE,
+		         "The samples of an incremental job are kept on the DPUs, so the triplets cannot be counted in several "
+		         "rounds. Given %d colors, no less than %d DPUs can be used.",
+		         job->colors, get_count_job_triplets(job));
+		return false;
+	}
+
+	// The degrees of the next jobs are not known, the nodes could not keep their labels
+	if (job->is_incremental && job->degree_order) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "The degree ordering cannot be used with incremental jobs.");
+		return false;
+	}
+
+	// The edges leaving the window would be deleted twice
+	if (job->window_size > 0 && job->has_deletions) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "The deletions cannot be used with sliding windows.");
+		return false;
+	}
+
+	if (job->window_size > 0 && job->is_incremental) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "The sliding windows cannot be used with incremental jobs.");
+		return false;
+	}
+
+	// The samples are counted at the end of each period, and the next edges are added to them
+	if (job->window_size > 0 && get_count_job_triplets(job) > nr_dpus) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE,
+		         "The samples of a sliding window are kept on the DPUs, so the triplets cannot be counted in several "
+		         "rounds. Given %d colors, no less than %d DPUs can be used.",
+		         job->colors, get_count_job_triplets(job));
+		return false;
+	}
+
+	if (is_dynamic && job->degree_order) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "The degree ordering cannot be used with deletions or sliding windows.");
+		return false;
+	}
+
+	// An edge can be deleted and inserted again, it is not a duplicate
+	if (is_dynamic && job->dedup_memory > 0) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "Duplicate edges cannot be removed with deletions or sliding windows.");
+		return false;
+	}
+
+	// The local counts are read once, with the degrees of the nodes at the end of the graph
+	if (job->local_counts_path != NULL && (is_dynamic || job->is_incremental)) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE,
+		         "The local counts cannot be used with deletions, sliding windows or incremental jobs.");
+		return false;
+	}
+
+	// The DPUs would count the triangles of the ranks, not of the nodes
+	if (job->local_counts_path != NULL && job->degree_order) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "The degree ordering cannot be used with the local counts.");
+		return false;
+	}
+
+	// A deletion must reach the DPUs after the edge it deletes. A single thread reads the graph in order
+	if (is_dynamic) {
+		job->nr_threads = 1;
+	}
+
+	// The graphs in memory are neither files nor streams
+	if (job->edges != NULL) {
+		if (job->is_time_window) {
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "Time windows need the timestamps of a graph in COO format.");
+			return false;
+		}
+		return true;
+	}
+
+	// "-" reads the graph from the standard input
+	bool        is_stdin = strcmp(job->filename, "-") == 0;
+	struct stat file_stat;
+	if (is_stdin) {
+		fstat(STDIN_FILENO, &file_stat);
+	} else if (stat(job->filename, &file_stat) != 0) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "File does not exist.");
+		return false;
+	}
+
+	// Anything else (a directory, an empty or unreadable file) cannot be mapped or read
+	if (!is_stdin) {
+		if (!S_ISREG(file_stat.st_mode) && !S_ISFIFO(file_stat.st_mode)) {
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "The graph must be a regular file or a FIFO.");
+			return false;
+		}
+		if (S_ISREG(file_stat.st_mode) && file_stat.st_size == 0) {
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "The graph file is empty.");
+			return false;
+		}
+		if (access(job->filename, R_OK) != 0) {
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "The graph file cannot be read.");
+			return false;
+		}
+	}
+
+	bool is_stream = is_stdin || S_ISFIFO(file_stat.st_mode);
+	if (is_stream && job->degree_order) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE,
+		         "The degree ordering reads the graph twice, it cannot be used with streams.");
+		return false;
+	}
+
+	if (is_stream && get_count_job_triplets(job) > nr_dpus) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE,
+		         "A stream can only be read once, so the triplets cannot be counted in several rounds. "
+		         "Given %d colors, no less than %d DPUs can be used.",
+		         job->colors, get_count_job_triplets(job));
+		return false;
+	}
+
+	return true;
+}
+
+void create_dpu_context(dpu_context_t* context, uint32_t nr_dpus, uint32_t nr_tasklets, bool in_background) {
+	context->nr_dpus         = nr_dpus;
+	context->nr_tasklets     = nr_tasklets;
+	context->is_allocating   = in_background;
+	context->is_used         = false;
+	context->allocation_time = 0;
+	context->nr_increments   = 0;
+	context->colorings       = NULL;
+
+	context->allocation_args =
+	    (dpu_allocation_args_t){.dpu_set = &context->dpu_set, .nr_dpus = nr_dpus, .nr_tasklets = nr_tasklets};
+
+	// If it's possible to use multiple threads, allocate the DPUs using another thread.
+	// Otherwise, the calling thread does it
+	if (in_background) {
+		pthread_create(&context->allocation_thread, NULL, allocate_dpus, (void*)&context->allocation_args);
+	} else {
+		struct timeval start, now;
+		gettimeofday(&start, 0);
+		allocate_dpus((void*)&context->allocation_args);
+		gettimeofday(&now, 0);
+		context->allocation_time = timedifference_msec(start, now);
+	}
+}
+
+static void wait_dpu_context(dpu_context_t* context) {
+	if (context->is_allocating) {
+		pthread_join(context->allocation_thread, NULL);
+		context->is_allocating = false;
+	}
+}
+
+void delete_dpu_context(dpu_context_t* context) {
+	wait_dpu_context(context);
+	DPU_ASSERT(dpu_free(context->dpu_set));
+	free(context->colorings);
+}
+
+// The edges of the job can be added to the samples of the previous incremental jobs if they are sampled the same way
+static bool is_same_sampling(const count_job_t* job, const count_job_t* sampling_job) {
+	return job->seed == sampling_job->seed && job->sample_size == sampling_job->sample_size &&
+	       job->p == sampling_job->p && job->t == sampling_job->t && job->colors == sampling_job->colors &&
+	       job->coloring_candidates == sampling_job->coloring_candidates &&
+	       job->nr_estimators == sampling_job->nr_estimators && job->has_deletions == sampling_job->has_deletions;
+}
+
+// Print the progress of the job, unless it is quiet
+static void print_progress(const count_job_t* job, const char* format, ...) {
+	if (!job->is_quiet) {
+		va_list arguments;
+		va_start(arguments, format);
+		vprintf(format, arguments);
+		va_end(arguments);
+	}
+}
+
+void delete_count_result(count_result_t* result) {
+	free(result->estimations);
+	free(result->windows);
+}
+
+// Estimation of each estimator from the triangles of its triplets, corrected for the uniform sampling
+static void estimate_triangles(const uint64_t* triplet_estimations, uint32_t colors, uint32_t nr_estimators, float p,
+                               uint64_t edges_kept, uint64_t edges_in_graph, double* estimations) {
+	uint32_t triplets_created = round((1.0 / 6) * colors * (colors + 1) * (colors + 2));
+
+	for (uint32_t estimator = 0; estimator < nr_estimators; estimator++) {
+
+		////Adjust the result knowing that some triangles may have been counted multiple times
+		uint64_t estimator_estimation =
+		    combine_triplet_estimations(&triplet_estimations[estimator * triplets_created], colors);
+
+		////Adjust the result due to lost triangles caused by uniform sampling
+		if (fabs(p - 1.0) > EPSILON && edges_kept > 0) { // p != 1
+			// Not using p directly to be more precise
+			estimator_estimation /= pow(((double)edges_kept / edges_in_graph), 3);
+		}
+
+		estimations[estimator] = estimator_estimation;
+	}
+}
+
+// Count the triangles of the window at the end of a period. The DPUs count a sorted copy of their samples with the
+// execution code 3, so that the edges of the next period are added to the samples
+static void count_window(const count_job_t* job, struct dpu_set_t dpu_set, const create_batches_args_t* args,
+                         uint32_t max_node_id, uint64_t* triplet_estimations, uint32_t nr_triplets,
+                         count_result_t* result) {
+	DPU_ASSERT(dpu_sync(dpu_set)); // The DPUs are done with the batches of the period
+	set_execution_code(dpu_set, 3, max_node_id);
+	DPU_ASSERT(dpu_launch(dpu_set, DPU_SYNCHRONOUS));
+	read_triangle_estimations(dpu_set, triplet_estimations, nr_triplets);
+	set_execution_code(dpu_set, 0, 0);
+
+	// The window is read by a single thread
+	uint64_t edges_in_window = args->total_edges_thread - args->deleted_edges;
+	uint64_t edges_kept      = args->edges_kept - args->deleted_edges_kept;
+
+	double* estimations = (double*)malloc(job->nr_estimators * sizeof(double));
+	estimate_triangles(triplet_estimations, job->colors, job->nr_estimators, job->p, edges_kept, edges_in_window,
+	                   estimations);
+	uint64_t triangles = median_of_means(estimations, job->nr_estimators, get_nr_mean_groups(job->nr_estimators));
+	free(estimations);
+
+	result->windows =
+	    (window_estimate_t*)realloc(result->windows, (result->nr_windows + 1) * sizeof(window_estimate_t));
+	result->windows[result->nr_windows++] =
+	    (window_estimate_t){.end = args->window->counted_end, .edges = edges_in_window, .triangles = triangles};
+
+	print_progress(job, "Window ending at %lu: %lu edges, %lu triangles\n", args->window->counted_end,
+	               edges_in_window, triangles);
+}
+
+bool run_count_job(count_job_t* job, dpu_context_t* context, count_result_t* result, char* error) {
+	// Parameters of the job, named as the options
+	int32_t  seed                = job->seed;
+	uint32_t sample_size         = job->sample_size;
+	float    p                   = job->p;
+	uint32_t k                   = job->k;
+	uint32_t t                   = job->t;
+	uint32_t colors              = job->colors;
+	char*    filename            = job->filename;
+	uint64_t memory_budget       = job->memory_budget;
+	uint32_t nr_threads          = job->nr_threads;
+	uint64_t dedup_memory        = job->dedup_memory;
+	char*    cache_dir           = job->cache_dir;
+	bool     degree_order        = job->degree_order;
+	uint32_t coloring_candidates = job->coloring_candidates;
+	uint32_t nr_estimators       = job->nr_estimators;
+
+	uint32_t triplets_created = round((1.0 / 6) * colors * (colors + 1) * (colors + 2));
+	uint32_t nr_triplets      = get_count_job_triplets(job);
+
+	// With fewer DPUs than triplets, the triplets are counted in several rounds on the same DPUs. The graph is read
+	// again in each round, and only the edges of the triplets of the round are sent
+	uint32_t triplets_per_round = (nr_triplets < context->nr_dpus) ? nr_triplets : context->nr_dpus;
+	uint32_t nr_rounds          = (nr_triplets + triplets_per_round - 1) / triplets_per_round;
+
+	bool is_in_memory = job->edges != NULL;
+	bool is_stdin     = !is_in_memory && strcmp(filename, "-") == 0;
+	bool is_windowed  = job->window_size > 0;
+	bool is_dynamic   = job->has_deletions || is_windowed; // The DPUs handle deletions
+
+	bool has_local_counts = job->local_counts_path != NULL;
+
+	////Start counting the time
+	struct timeval start;
+	gettimeofday(&start, 0);
+
+	////Load the file into memory. Faster access from threads when reading edges
+	struct stat file_stat = {0}; // Empty for the graphs in memory
+	if (is_stdin) {
+		fstat(STDIN_FILENO, &file_stat);
+	} else if (!is_in_memory) {
+		stat(filename, &file_stat);
+	}
+
+	// Streams (standard input or FIFOs) cannot be mmapped. They are read in chunks by another thread, using a ring of
+	// buffers of fixed size, so that the memory used does not depend on the size of the graph
+	bool            is_stream           = is_stdin || S_ISFIFO(file_stat.st_mode);
+	char*           mmaped_file         = NULL;
+	bool            is_binary           = false;
+	const edge_t*   binary_edges        = NULL; // Edges of a binary file or of the graph in memory
+	uint32_t        nr_stream_chunks    = 0;
+	uint64_t        stream_buffers_size = 0;
+	stream_reader_t stream_reader;
+
+	binary_graph_header_t binary_header = {0};
+
+	if (is_stream) {
+		// Two chunks per thread, so that the reader thread can fill a chunk while the others are parsed.
+		// If a memory budget is given, the buffers do not use more than a quarter of it, and at least two chunks and
+		// the buffer of the incomplete lines must fit
+		nr_stream_chunks = 2 * nr_threads;
+		if (memory_budget > 0) {
+			uint64_t stream_memory = memory_budget / 4;
+			if (stream_memory < 3 * (uint64_t)STREAM_CHUNK_SIZE) {
+				snprintf(error, COUNT_JOB_ERROR_SIZE,
+				         "The memory budget is too small for streaming. At least %lu MB are needed.",
+				         4 * 3 * (uint64_t)STREAM_CHUNK_SIZE / (1024 * 1024));
+				return false;
+			}
+			uint64_t max_stream_chunks = stream_memory / STREAM_CHUNK_SIZE - 1;
+			nr_stream_chunks = (nr_stream_chunks < max_stream_chunks) ? nr_stream_chunks : max_stream_chunks;
+		}
+		// One more buffer for incomplete lines
+		stream_buffers_size = ((uint64_t)nr_stream_chunks + 1) * STREAM_CHUNK_SIZE;
+	}
+
+	// The edges sent to each DPU can be cached, so that the next runs on the same graph with the same seed, colors,
+	// -p and -u send them directly from the cache files, without reading and coloring the graph again
+	batch_cache_t batch_cache;
+	bool          is_cache_hit     = false;
+	bool          is_cache_written = false;
+	uint64_t      cache_key        = 0;
+	if (cache_dir != NULL) {
+		if (is_stream) {
+			print_progress(job, "Streams cannot be cached. The cache is not used.\n");
+			cache_dir = NULL;
+		} else if (is_in_memory) {
+			print_progress(job, "Graphs in memory cannot be cached. The cache is not used.\n");
+			cache_dir = NULL;
+		} else if (is_windowed) {
+			print_progress(job, "The counts of the windows cannot be cached. The cache is not used.\n");
+			cache_dir = NULL;
+		} else if (has_local_counts) {
+			print_progress(job, "The local counts need the degrees of the nodes. The cache is not used.\n");
+			cache_dir = NULL;
+		} else if (job->is_incremental) {
+			// The next incremental jobs route their edges with the colorings of the first one, chosen while reading
+			print_progress(job, "Incremental jobs cannot be cached. The cache is not used.\n");
+			cache_dir = NULL;
+		} else {
+			cache_key    = get_batch_cache_key(&file_stat, seed, colors, p, dedup_memory, degree_order,
+			                                   coloring_candidates, nr_estimators, job->has_deletions, k, t);
+			is_cache_hit = open_batch_cache(&batch_cache, cache_dir, cache_key, nr_triplets);
+		}
+	}
+
+	// The file is mapped, and the header of a binary graph is checked, before anything else is allocated, so that the
+	// job can be refused. The cached batches are sent without reading the file
+	if (!is_stream && !is_in_memory && !is_cache_hit) {
+		int file_fd = open(filename, O_RDONLY);
+		if (file_fd < 0) {
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "Cannot open the file %s.", filename);
+			return false;
+		}
+		mmaped_file = (char*)mmap(0, file_stat.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, file_fd, 0);
+		close(file_fd);
+		if (mmaped_file == MAP_FAILED) {
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "Cannot map the file %s.", filename);
+			return false;
+		}
+
+		// Binary edge lists are consumed directly from the mmapped file, split among the threads by edge index
+		is_binary = is_binary_graph(mmaped_file, file_stat.st_size);
+		if (is_binary) {
+			if (!read_binary_graph_header(mmaped_file, file_stat.st_size, &binary_header, error,
+			                              COUNT_JOB_ERROR_SIZE)) {
+				munmap(mmaped_file, file_stat.st_size);
+				return false;
+			}
+			binary_edges = binary_graph_edges(mmaped_file);
+		}
+
+		// The windows are not cached
+		if (is_binary && job->is_time_window) {
+			munmap(mmaped_file, file_stat.st_size);
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "Time windows need the timestamps of a graph in COO format.");
+			return false;
+		}
+
+		// An insertion with such a node id would be read as a deletion, so the max node id is checked at once
+		if (is_binary && is_dynamic && (binary_header.max_node_id & EDGE_DELETION_FLAG)) {
+			munmap(mmaped_file, file_stat.st_size);
+			snprintf(error, COUNT_JOB_ERROR_SIZE,
+			         "With deletions or windows, the node ids must be lower than 2^31. Max node id: %u",
+			         binary_header.max_node_id);
+			return false;
+		}
+	}
+
+	// The file of the local counts is created before anything else is allocated, so that the job can be refused
+	FILE* local_counts_file = NULL;
+	if (has_local_counts) {
+		local_counts_file = fopen(job->local_counts_path, "wb");
+		if (local_counts_file == NULL) {
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "Cannot create the file of the local counts: %s",
+			         job->local_counts_path);
+			if (mmaped_file != NULL) {
+				munmap(mmaped_file, file_stat.st_size);
+			}
+			return false;
+		}
+	}
+
+	// The batches use a pool of fixed size: the given budget, or DEFAULT_BATCH_MEMORY without using more than 90% of
+	// the free memory. It is checked before anything is allocated, so that the job can be refused
+	uint64_t batches_memory = 0;
+	uint64_t chunk_edges    = 0;
+	if (!is_cache_hit) { // The cached batches are sent directly from the cache files
+		uint64_t other_memory = stream_buffers_size + dedup_memory; // Allocated next to the batches
+		if (memory_budget > 0) {
+			batches_memory = (memory_budget > other_memory) ? memory_budget - other_memory : 0;
+		} else {
+			batches_memory = 0.9 * get_free_memory();
+			batches_memory = (batches_memory > other_memory) ? batches_memory - other_memory : 0;
+			batches_memory = (batches_memory > DEFAULT_BATCH_MEMORY) ? DEFAULT_BATCH_MEMORY : batches_memory;
+		}
+
+		// The threads share a batch for each triplet of the round
+		chunk_edges = get_chunk_edges(batches_memory, triplets_per_round);
+		if (chunk_edges == 0) {
+			uint64_t min_batches_memory = 2 * MIN_CHUNK_EDGES * sizeof(edge_t) * triplets_per_round;
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "The memory budget is too small. At least %lu MB are needed.",
+			         (other_memory + min_batches_memory) / (1024 * 1024) + 1);
+			if (local_counts_file != NULL) {
+				fclose(local_counts_file);
+			}
+			if (mmaped_file != NULL) {
+				munmap(mmaped_file, file_stat.st_size);
+			}
+			return false;
+		}
+
+		if (cache_dir != NULL) {
+			create_batch_cache(&batch_cache, cache_dir, cache_key, nr_triplets);
+			is_cache_written = true;
+		}
+	}
+
+	if (is_stream && coloring_candidates > 1) {
+		print_progress(job, "The candidate colorings cannot be compared on streams. The first one is used.\n");
+		coloring_candidates = 1;
+	}
+
+	if (is_stream) {
+		int stream_fd = is_stdin ? STDIN_FILENO : open(filename, O_RDONLY);
+		if (stream_fd < 0) {
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "Cannot open the file %s.", filename);
+			if (local_counts_file != NULL) {
+				fclose(local_counts_file);
+			}
+			return false;
+		}
+		create_stream_reader(&stream_reader, stream_fd, nr_stream_chunks, STREAM_CHUNK_SIZE);
+	} else if (is_in_memory) {
+		// The edges in memory are read like a binary file whose edges are not normalized
+		is_binary              = true;
+		binary_edges           = job->edges;
+		binary_header.nr_edges = job->nr_edges;
+	}
+
+	// Duplicate edges (also with swapped nodes) and self-loops are dropped before being sent to the DPUs.
+	// All the threads share the same set, so that duplicates handled by different threads are found
+	edge_set_t edge_set;
+	if (dedup_memory > 0 && !is_cache_hit) {
+		create_edge_set(&edge_set, dedup_memory);
+	}
+
+	////Allocate the memory used to store the batches to send to the DPUs
+	batch_pool_t batch_pool;
+	if (!is_cache_hit) {
+		create_batch_pool(&batch_pool, batches_memory, chunk_edges);
+	}
+
+	////Initializing DPUs
+	// If the DPUs are allocated by another thread, wait for the allocation to finish
+	wait_dpu_context(context);
+	struct dpu_set_t dpu_set = context->dpu_set;
+
+	// The edges of an incremental job are added to the samples of the previous incremental job, if they are sampled the
+	// same way. The first job of the samples was checked, so the job has a single round
+	bool is_continued =
+	    job->is_incremental && context->nr_increments > 0 && is_same_sampling(job, &context->sampling_job);
+
+	// Sending the input arguments to the DPUs
+	dpu_arguments_t input_arguments = {
+	    .seed             = seed,
+	    .sample_size      = sample_size,
+	    .t                = t,
+	    .has_deletions    = is_dynamic,
+	    .has_local_counts = has_local_counts,
+	};
+
+	if (is_continued) {
+		// The last launch was a query, the next batches are added to the samples
+		set_execution_code(dpu_set, 0, 0);
+		print_progress(job, "Edges added to the samples of %u incremental jobs\n", context->nr_increments);
+	} else {
+		// The DPUs keep the sample of the previous job until they are reset
+		if (context->is_used) {
+			reset_dpus(dpu_set);
+		}
+
+		// Launch DPUs for setup
+		setup_dpus(dpu_set, &input_arguments, 0, triplets_created);
+
+		context->nr_increments = 0;
+		if (job->is_incremental) {
+			context->sampling_job   = *job;
+			context->colorings      = (uint32_t*)realloc(context->colorings, nr_estimators * sizeof(uint32_t));
+			context->edges_in_graph = 0;
+			context->edges_kept     = 0;
+			context->max_node_id    = 0;
+		}
+	}
+	context->is_used = true;
+
+	struct timeval now;
+	gettimeofday(&now, 0);
+
+	// The first job also pays the allocation of the DPUs, if it was not done in the background
+	float setup_time = timedifference_msec(start, now) + context->allocation_time;
+	print_progress(job, "Time for the setup: %f\n", setup_time);
+	context->allocation_time = 0;
+
+	gettimeofday(&start, 0);
+
+	// Filled at the end of each period of the window
+	result->windows    = NULL;
+	result->nr_windows = 0;
+
+	////Prepare variables for threads that will create the sample
+	// Information needed to count the triangles, given by the threads or by the cache
+	uint32_t          max_node_id        = 0;
+	uint64_t          edges_in_graph     = 0;
+	uint64_t          edges_kept         = 0;
+	uint64_t          nr_top_nodes       = 0;
+	node_frequency_t* top_frequent_nodes = (node_frequency_t*)malloc(t * sizeof(node_frequency_t));
+
+	// First edge of a graph with deletions or windows with a node id that the DPUs would take for a deletion
+	bool   has_invalid_edge = false;
+	edge_t invalid_edge     = {0};
+
+	// Edges received and triangles estimated by each triplet, filled round after round
+	uint64_t* triplet_edges       = (uint64_t*)calloc(nr_triplets, sizeof(uint64_t));
+	uint64_t* triplet_estimations = (uint64_t*)malloc(nr_triplets * sizeof(uint64_t));
+
+	if (nr_rounds > 1) {
+		print_progress(job, "Triplets counted in %u rounds of %u DPUs\n", nr_rounds, triplets_per_round);
+	}
+
+	// Used by the threads creating the batches in all the rounds
+	pthread_t*             threads             = NULL;
+	create_batches_args_t* create_batches_args = NULL;
+	node_frequency_t**     top_freq            = NULL;
+	routing_table_t*       routing_tables      = NULL; // One for each estimator
+	pthread_t              stream_reader_thread;
+	chunk_scheduler_t      scheduler;
+	_Atomic uint32_t*      degrees         = NULL;
+	uint32_t               max_degrees_id  = (is_binary && !is_in_memory) ? binary_header.max_node_id : UINT32_MAX;
+	uint32_t               nr_ranked_nodes = 0;
+	sliding_window_t       window;
+	local_counts_t         local_counts;
+
+	if (is_cache_hit) {
+		max_node_id    = batch_cache.header.max_node_id;
+		edges_in_graph = batch_cache.header.total_edges;
+		edges_kept     = batch_cache.header.edges_kept;
+
+		// The top frequent nodes are the ones found by the run that created the cache
+		nr_top_nodes = (batch_cache.header.nr_top_nodes < t) ? batch_cache.header.nr_top_nodes : t;
+		memcpy(top_frequent_nodes, batch_cache.top_nodes, nr_top_nodes * sizeof(node_frequency_t));
+
+		print_progress(job, "Batches read from the cache %s\n", batch_cache.path);
+	} else {
+		// Handle edges in different threads
+		threads             = (pthread_t*)malloc(nr_threads * sizeof(pthread_t));
+		create_batches_args = (create_batches_args_t*)malloc(nr_threads * sizeof(create_batches_args_t));
+
+		// Contains the most frequent nodes in the section of edges analysed by a single thread
+		// Only top 2*t are kept considering that t are sent to the DPUs
+		top_freq = (node_frequency_t**)malloc(nr_threads * sizeof(node_frequency_t*));
+		for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+			if (k > 0) {
+				top_freq[th_id] = (node_frequency_t*)malloc(2 * t * sizeof(node_frequency_t));
+			} else {
+				top_freq[th_id] = NULL; // Do not waste space if Space-Saving is not used
+			}
+		}
+
+		////Start edge creation
+		if (is_stream) {
+			pthread_create(&stream_reader_thread, NULL, read_stream, (void*)&stream_reader);
+		}
+
+		// Split the file into many small chunks. Each thread starts from its own section of chunks, and when it is over
+		// it steals chunks from the other threads, so that no thread is left behind (uneven lines, page faults, shared
+		// cores)
+		if (is_binary) {
+			create_edges_chunk_scheduler(&scheduler, binary_header.nr_edges, nr_threads);
+		} else if (!is_stream) {
+			create_file_chunk_scheduler(&scheduler, mmaped_file, file_stat.st_size, nr_threads);
+		}
+
+		// First pass over the graph: exact degree of every node. The nodes are then relabeled by (degree, id), so that
+		// every edge goes from the lower degree node to the higher one and the DPUs intersect shorter neighbor lists
+		if (degree_order) {
+			struct timeval degrees_start;
+			gettimeofday(&degrees_start, 0);
+
+			degrees = create_degrees(max_degrees_id);
+			count_degrees_args_t* degrees_args =
+			    (count_degrees_args_t*)malloc(nr_threads * sizeof(count_degrees_args_t));
+			for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+				degrees_args[th_id] = (count_degrees_args_t){
+				    .th_id        = th_id,
+				    .mmaped_file  = mmaped_file,
+				    .file_size    = file_stat.st_size,
+				    .binary_edges = binary_edges,
+				    .scheduler    = &scheduler,
+				    .edge_set     = (dedup_memory > 0) ? &edge_set : NULL,
+				    .seed         = seed,
+				    .p            = p,
+				    .degrees      = degrees,
+				    .max_node_id  = 0,
+				};
+				pthread_create(&threads[th_id], NULL, count_degrees, (void*)&degrees_args[th_id]);
+			}
+
+			uint32_t max_graph_node_id = 0;
+			for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+				pthread_join(threads[th_id], NULL);
+				max_graph_node_id = (degrees_args[th_id].max_node_id > max_graph_node_id)
+				                        ? degrees_args[th_id].max_node_id
+				                        : max_graph_node_id;
+			}
+			free(degrees_args);
+
+			nr_ranked_nodes = rank_nodes_by_degree(degrees, max_graph_node_id);
+			reset_chunk_scheduler(&scheduler); // The second pass creates the batches
+			if (dedup_memory > 0) {
+				reset_edge_set(&edge_set);
+			}
+
+			gettimeofday(&now, 0);
+			print_progress(job, "Time for the degree ordering: %f\n", timedifference_msec(degrees_start, now));
+		}
+
+		// The coloring decides how many edges each DPU receives. If more candidates are given, they are compared on
+		// the start of the graph, after the relabeling by degree
+		edge_t*  coloring_sample = NULL;
+		uint64_t nr_sample_edges = 0;
+		if (coloring_candidates > 1 && !is_continued) {
+			coloring_sample = (edge_t*)malloc(COLORING_SAMPLE_EDGES * sizeof(edge_t));
+			nr_sample_edges = read_coloring_sample(mmaped_file, file_stat.st_size, binary_edges,
+			                                       is_binary ? binary_header.nr_edges : 0, (const uint32_t*)degrees,
+			                                       coloring_sample);
+		}
+
+		// The estimators use colorings derived from different seeds, so that they are independent
+		routing_tables = (routing_table_t*)malloc(nr_estimators * sizeof(routing_table_t));
+		for (uint32_t estimator = 0; estimator < nr_estimators; estimator++) {
+			uint32_t coloring = 0;
+			if (is_continued) {
+				coloring = context->colorings[estimator]; // The edges in the samples were routed with it
+			} else if (coloring_candidates > 1) {
+				double sample_load_ratio;
+				coloring = choose_coloring(seed + estimator, coloring_candidates, colors, coloring_sample,
+				                           nr_sample_edges, triplets_created, &sample_load_ratio);
+
+				print_progress(job, "Coloring %u of %u chosen, load of the DPUs on %lu edges (max/mean): %f\n",
+				               coloring + 1, coloring_candidates, nr_sample_edges, sample_load_ratio);
+			}
+
+			if (job->is_incremental) {
+				context->colorings[estimator] = coloring;
+			}
+
+			create_routing_table(&routing_tables[estimator], colors, get_hash_parameters(seed + estimator, coloring));
+		}
+		free(coloring_sample);
+
+		if (is_windowed) {
+			create_sliding_window(&window, job->window_size, job->window_period, job->is_time_window);
+		}
+
+		// The degrees are counted by the threads creating the batches of the first round
+		if (has_local_counts) {
+			create_local_counts(&local_counts, max_degrees_id, nr_threads);
+		}
+	}
+
+	for (uint32_t round = 0; round < nr_rounds; round++) {
+		uint32_t first_triplet     = round * triplets_per_round;
+		uint32_t nr_round_triplets = nr_triplets - first_triplet;
+		nr_round_triplets          = (nr_round_triplets < triplets_per_round) ? nr_round_triplets : triplets_per_round;
+
+		if (is_cache_hit) {
+			// The DPUs are done with the previous round. All the rounds but the last have triplets_per_round triplets
+			if (round > 0) {
+				read_triangle_estimations(dpu_set, &triplet_estimations[first_triplet - triplets_per_round],
+				                          triplets_per_round);
+				reset_dpus(dpu_set);
+				setup_dpus(dpu_set, &input_arguments, first_triplet, triplets_created);
+			}
+
+			// The edges were already colored and split among the DPUs by a previous run
+			send_batch_cache(&batch_cache, dpu_set, first_triplet, nr_round_triplets);
+			memcpy(&triplet_edges[first_triplet], &batch_cache.edge_counts[first_triplet],
+			       nr_round_triplets * sizeof(uint64_t));
+		} else {
+			// The graph is read again from the start, with an empty set of edges
+			if (round > 0) {
+				reset_chunk_scheduler(&scheduler);
+				if (dedup_memory > 0) {
+					reset_edge_set(&edge_set);
+				}
+			}
+
+			// The threads append the edges to batches shared by all of them, and only the sender thread transfers the
+			// batches, so the other threads never wait for the DPUs
+			dpu_sender_t sender;
+			pthread_t    sender_thread;
+			uint32_t     nr_launches = 0;
+
+			for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+
+				create_batches_args[th_id] = (create_batches_args_t){
+				    .th_id              = th_id,
+				    .max_node_id        = 0,
+				    .mmaped_file        = mmaped_file,
+				    .file_size          = file_stat.st_size,
+				    .scheduler          = &scheduler,
+				    .binary_edges       = binary_edges,
+				    .is_normalized      = is_binary && (binary_header.flags & BINARY_GRAPH_NORMALIZED) && !degree_order,
+				    .stream_reader      = is_stream ? &stream_reader : NULL,
+				    .edge_set           = (dedup_memory > 0) ? &edge_set : NULL,
+				    .duplicate_edges    = 0,
+				    .self_loops         = 0,
+				    .untracked_edges    = 0,
+				    .node_ranks         = (const uint32_t*)degrees, // Not updated anymore
+				    .degrees            = (has_local_counts && round == 0) ? local_counts.degrees : NULL,
+				    .seed               = seed,
+				    .p                  = p,
+				    .edges_kept         = 0,
+				    .total_edges_thread = 0,
+				    .has_deletions      = job->has_deletions,
+				    .deleted_edges      = 0,
+				    .deleted_edges_kept = 0,
+				    .has_invalid_edge   = false,
+				    .window             = is_windowed ? &window : NULL,
+				    .k                  = (round == 0) ? k : 0, // The top frequent nodes do not change
+				    .t                  = t,
+				    .top_freq           = top_freq[th_id],
+				    .routing_tables     = routing_tables,
+				    .nr_estimators      = nr_estimators,
+				    .sender             = &sender,
+				    .blocked_time       = 0,
+				};
+			}
+
+			// The graph is read in a single segment, unless the window is counted at the end of each period. The
+			// thread then stops, and the next one resumes once the samples are counted
+			bool is_input_over = false;
+			while (!is_input_over) {
+				create_dpu_sender(&sender, dpu_set, first_triplet, nr_round_triplets, &batch_pool, nr_threads,
+				                  is_cache_written ? &batch_cache : NULL);
+
+				for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+					pthread_create(&threads[th_id], NULL, handle_edges_file, (void*)&create_batches_args[th_id]);
+				}
+
+				// The threads fill the pool while the DPUs count the triangles of the previous round. The batches are
+				// only sent once the DPUs are ready for the next triplets
+				if (round > 0) {
+					read_triangle_estimations(dpu_set, &triplet_estimations[first_triplet - triplets_per_round],
+					                          triplets_per_round);
+					if (has_local_counts) {
+						read_local_counts(&local_counts, dpu_set, first_triplet - triplets_per_round,
+						                  triplets_per_round, colors, max_node_id, top_frequent_nodes, nr_top_nodes);
+					}
+					reset_dpus(dpu_set);
+					setup_dpus(dpu_set, &input_arguments, first_triplet, triplets_created);
+				}
+				pthread_create(&sender_thread, NULL, run_dpu_sender, (void*)&sender);
+
+				// Wait for all threads to finish, then for the sender to send their last batches
+				for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+					pthread_join(threads[th_id], NULL);
+				}
+				close_dpu_sender(&sender);
+				pthread_join(sender_thread, NULL);
+
+				nr_launches += sender.nr_launches;
+				for (uint32_t th_id = 0; th_id < nr_threads && !has_invalid_edge; th_id++) {
+					has_invalid_edge = create_batches_args[th_id].has_invalid_edge;
+					invalid_edge     = create_batches_args[th_id].invalid_edge;
+				}
+				for (uint32_t dpu_id = 0; dpu_id < nr_round_triplets; dpu_id++) {
+					triplet_edges[first_triplet + dpu_id] += sender.staging[dpu_id].edges_sent;
+				}
+				delete_dpu_sender(&sender);
+
+				is_input_over = !is_windowed || window.is_input_over;
+				if (!is_input_over) {
+					uint32_t window_max_node_id = (is_binary && !is_in_memory) ? binary_header.max_node_id
+					                                                           : create_batches_args[0].max_node_id;
+					count_window(job, dpu_set, &create_batches_args[0], window_max_node_id, triplet_estimations,
+					             nr_triplets, result);
+				}
+			}
+			print_progress(job, "Launches of the ranks: %u\n", nr_launches);
+
+			if (is_stream) {
+				pthread_join(stream_reader_thread, NULL);
+				if (!is_stdin) {
+					close(stream_reader.fd);
+				}
+				delete_stream_reader(&stream_reader);
+			}
+
+			// A thread is idle from when it finishes its edges until the last thread finishes
+			struct timeval last_thread_end = create_batches_args[0].end_time;
+			for (uint32_t th_id = 1; th_id < nr_threads; th_id++) {
+				if (timedifference_msec(last_thread_end, create_batches_args[th_id].end_time) > 0) {
+					last_thread_end = create_batches_args[th_id].end_time;
+				}
+			}
+
+			print_progress(job, "Idle time of the host threads:");
+			for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+				print_progress(job, " %f", timedifference_msec(create_batches_args[th_id].end_time, last_thread_end));
+			}
+			print_progress(job, "\n");
+
+			// A thread is blocked when the pool has no free chunks, or while another thread replaces a full chunk
+			print_progress(job, "Time blocked of the host threads:");
+			for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+				print_progress(job, " %f", create_batches_args[th_id].blocked_time);
+			}
+			print_progress(job, "\n");
+
+			// The other rounds read the same graph, only the first one is counted
+			if (round == 0) {
+				if (dedup_memory > 0) {
+					uint64_t duplicate_edges = 0, self_loops = 0, untracked_edges = 0;
+					for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+						duplicate_edges += create_batches_args[th_id].duplicate_edges;
+						self_loops += create_batches_args[th_id].self_loops;
+						untracked_edges += create_batches_args[th_id].untracked_edges;
+					}
+
+					print_progress(job, "Edges dropped: %lu duplicates, %lu self-loops\n", duplicate_edges, self_loops);
+					if (untracked_edges > 0) {
+						print_progress(job,
+						               "The set of edges was full, %lu edges were not checked for duplicates. "
+						               "Increase -u.\n",
+						               untracked_edges);
+					}
+				}
+
+				// Find the max node id. Necessary because the performance of quicksort highly depends on the accuracy
+				// of this value
+				max_node_id = (is_binary && !degree_order) ? binary_header.max_node_id : 0;
+				for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+					max_node_id = (max_node_id < create_batches_args[th_id].max_node_id)
+					                  ? create_batches_args[th_id].max_node_id
+					                  : max_node_id;
+				}
+
+				uint64_t deleted_edges = 0, deleted_edges_kept = 0;
+				for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+					edges_in_graph += create_batches_args[th_id].total_edges_thread;
+					edges_kept += create_batches_args[th_id].edges_kept;
+					deleted_edges += create_batches_args[th_id].deleted_edges;
+					deleted_edges_kept += create_batches_args[th_id].deleted_edges_kept;
+				}
+
+				// The edges of the graph are the ones left at the end of the stream, or in the last window
+				if (is_dynamic) {
+					print_progress(job, is_windowed ? "Edges out of the window: %lu\n" : "Edges deleted: %lu\n",
+					               deleted_edges);
+					edges_in_graph = (edges_in_graph > deleted_edges) ? edges_in_graph - deleted_edges : 0;
+					edges_kept     = (edges_kept > deleted_edges_kept) ? edges_kept - deleted_edges_kept : 0;
+				}
+
+				if (k > 0) {
+					nr_top_nodes = global_top_freq(top_freq, nr_threads, top_frequent_nodes, t);
+				}
+			}
+		}
+
+		// The last batches were sent, need to wait for them to be processed
+		DPU_ASSERT(dpu_sync(dpu_set));
+
+		if (k > 0) {
+			DPU_ASSERT(dpu_broadcast_to(dpu_set, DPU_MRAM_HEAP_POINTER_NAME, 0, top_frequent_nodes,
+			                            t * sizeof(node_frequency_t), DPU_XFER_DEFAULT));
+			DPU_ASSERT(
+			    dpu_broadcast_to(dpu_set, "nr_top_nodes", 0, &nr_top_nodes, sizeof(nr_top_nodes), DPU_XFER_DEFAULT));
+		}
+
+		// The sample creation of all the rounds includes the counting of the previous rounds
+		if (round == nr_rounds - 1) {
+			gettimeofday(&now, 0);
+			result->sample_creation_time = timedifference_msec(start, now);
+			print_progress(job, "Time for the sample creation: %f\n", result->sample_creation_time);
+
+			/*READING THE ESTIMATION FROM EVERY DPU*/
+			gettimeofday(&start, 0);
+		}
+
+		// The samples of the incremental jobs hold the edges of all of them. They have a single round
+		if (job->is_incremental) {
+			context->nr_increments++;
+			context->edges_in_graph += edges_in_graph;
+			context->edges_kept += edges_kept;
+			context->max_node_id = (context->max_node_id > max_node_id) ? context->max_node_id : max_node_id;
+		}
+
+		// Signal the DPUs to start counting. A query keeps the sample, so that the next increment can extend it
+		if (job->is_incremental) {
+			set_execution_code(dpu_set, 3, context->max_node_id);
+		} else {
+			set_execution_code(dpu_set, 1, max_node_id);
+		}
+
+		// Launch the DPUs program one last time for the triplets of the round
+		DPU_ASSERT(dpu_launch(dpu_set, DPU_ASYNCHRONOUS));
+	}
+
+	// Max over mean of the edges received by the DPUs with a triplet
+	result->load_ratio = get_load_ratio(triplet_edges, nr_triplets);
+	print_progress(job, "Load of the DPUs (max/mean edges): %f\n", result->load_ratio);
+	free(triplet_edges);
+
+	////Free memory while DPUs are counting the triangles
+	if (!is_cache_hit) {
+		if (!is_stream) {
+			delete_chunk_scheduler(&scheduler);
+		}
+		for (uint32_t estimator = 0; estimator < nr_estimators; estimator++) {
+			delete_routing_table(&routing_tables[estimator]);
+		}
+		free(routing_tables);
+
+		if (dedup_memory > 0) {
+			delete_edge_set(&edge_set);
+		}
+
+		if (degree_order) {
+			delete_degrees(degrees, max_degrees_id);
+			print_progress(job, "Nodes ranked by degree: %u\n", nr_ranked_nodes);
+		}
+
+		if (k > 0) {
+			for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
+				free(top_freq[th_id]);
+			}
+		}
+		free(top_freq);
+		free(threads);
+		free(create_batches_args);
+
+		if (is_windowed) {
+			delete_sliding_window(&window);
+		}
+
+		// The edges of a failed job are not kept
+		if (is_cache_written && has_invalid_edge) {
+			discard_batch_cache(&batch_cache);
+		} else if (is_cache_written) {
+			commit_batch_cache(&batch_cache, max_node_id, edges_in_graph, edges_kept, top_frequent_nodes, nr_top_nodes);
+		}
+
+		delete_batch_pool(&batch_pool);
+		if (mmaped_file != NULL) {
+			munmap(mmaped_file, file_stat.st_size); // Free mmapped memory (graph file)
+		}
+	}
+	if (is_cache_hit || is_cache_written) {
+		close_batch_cache(&batch_cache);
+	}
+
+	// The cache only has the edges of the job, but the samples of the incremental jobs hold the edges of all of them
+	if (job->is_incremental) {
+		edges_in_graph = context->edges_in_graph;
+		edges_kept     = context->edges_kept;
+	}
+
+	read_triangle_estimations(dpu_set, &triplet_estimations[(nr_rounds - 1) * triplets_per_round],
+	                          nr_triplets - (nr_rounds - 1) * triplets_per_round);
+
+	// The local counts are the mean of the estimators, corrected for the uniform sampling like the triangles
+	result->local_count_nodes = 0;
+	if (has_local_counts) {
+		read_local_counts(&local_counts, dpu_set, (nr_rounds - 1) * triplets_per_round,
+		                  nr_triplets - (nr_rounds - 1) * triplets_per_round, colors, max_node_id, top_frequent_nodes,
+		                  nr_top_nodes);
+
+		double local_counts_scale = 1.0 / nr_estimators;
+		if (fabs(p - 1.0) > EPSILON && edges_kept > 0) { // p != 1
+			local_counts_scale /= pow(((double)edges_kept / edges_in_graph), 3);
+		}
+
+		result->local_count_nodes =
+		    write_local_counts(&local_counts, local_counts_file, max_node_id, local_counts_scale);
+		fclose(local_counts_file);
+		delete_local_counts(&local_counts);
+		print_progress(job, "Local counts of %lu nodes written to %s\n", result->local_count_nodes,
+		               job->local_counts_path);
+	}
+	free(top_frequent_nodes);
+
+	// The DPUs are done, so the job can be refused. The samples miss the dropped edges, so the next incremental job
+	// starts new ones
+	if (has_invalid_edge) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE,
+		         "With deletions or windows, the node ids must be lower than 2^31. Invalid edge: %u %u",
+		         invalid_edge.u, invalid_edge.v);
+		if (job->is_incremental) {
+			context->nr_increments = 0;
+		}
+		free(triplet_estimations);
+		free(result->windows);
+		result->windows    = NULL;
+		result->nr_windows = 0;
+		return false;
+	}
+
+	// Each estimator gives an estimation of the triangles from the triplets of its coloring
+	double* estimations = (double*)malloc(nr_estimators * sizeof(double));
+	estimate_triangles(triplet_estimations, colors, nr_estimators, p, edges_kept, edges_in_graph, estimations);
+
+	// The median of means is robust to the estimators far from the others
+	uint32_t nr_mean_groups = get_nr_mean_groups(nr_estimators);
+	result->triangles       = median_of_means(estimations, nr_estimators, nr_mean_groups);
+	result->estimations     = estimations;
+	result->nr_estimators   = nr_estimators;
+	result->edges_in_graph  = edges_in_graph;
+	result->edges_kept      = edges_kept;
+	result->nr_rounds       = nr_rounds;
+	result->nr_increments   = context->nr_increments;
+	result->setup_time      = setup_time;
+
+	if (nr_estimators > 1) {
+		print_progress(job, "Triangles of the estimators:");
+		for (uint32_t estimator = 0; estimator < nr_estimators; estimator++) {
+			print_progress(job, " %.0f", estimations[estimator]);
+		}
+		print_progress(job, "\n");
+
+		get_bootstrap_interval(estimations, nr_estimators, nr_mean_groups, seed, &result->interval_low,
+		                       &result->interval_high);
+		print_progress(job, "Median of means of %u groups, %.0f%% confidence interval: [%.0f, %.0f]\n", nr_mean_groups,
+		               ENSEMBLE_CONFIDENCE * 100, result->interval_low, result->interval_high);
+	} else {
+		result->interval_low  = result->triangles;
+		result->interval_high = result->triangles;
+	}
+
+	free(triplet_estimations);
+
+	// For debug purpose, get standard output from the DPUs
+	/*DPU_FOREACH(dpu_set, dpu) {
+	    DPU_ASSERT(dpu_log_read(dpu, stdout));
+	}*/
+
+	gettimeofday(&now, 0);
+
+	result->counting_time = timedifference_msec(start, now);
+	print_progress(job, "Time to count the triangles: %f\n", result->counting_time);
+
+	print_progress(job, "Triangles: %ld\n", result->triangles);
+
+	return true;
+}
@@ -0,0 +1,124 @@
+#ifndef __COUNT_JOB_H__
+#define __COUNT_JOB_H__
+
+#include <dpu.h>
+#include <pthread.h> // Allocate the DPUs in another thread
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+
+#include "../common/common.h"
+#include "host_util.h"
+
+// Size of the buffers receiving the error messages
+#define COUNT_JOB_ERROR_SIZE 256
+
+// Parameters of a triangle counting on a graph. They are the options of the command line, see usage()
+typedef struct {
+	int32_t  seed;                // Seed for random numbers
+	uint32_t sample_size;         // Sample size in DPUs
+	float    p;                   // Probability of ignoring edges
+	uint32_t k;                   // Number of Space-Saving counters for each thread
+	uint32_t t;                   // Max number of top frequent nodes to send to the DPUs
+	uint32_t colors;              // Number of colors to use
+	char*    filename;            // Name of the file in COO format
+	uint64_t memory_budget;       // Max bytes used for the batches, the stream buffers and the edge set. 0 if not given
+	uint32_t nr_threads;          // Number of host threads creating the batches
+	uint64_t dedup_memory;        // Max bytes used to find duplicate edges. 0 if duplicates are not removed
+	char*    cache_dir;           // Directory of the batch cache. NULL if not used
+	bool     degree_order;        // Relabel the nodes by degree before sending the edges
+	uint32_t coloring_candidates; // Colorings compared on the start of the graph, the most balanced one is used
+	uint32_t nr_estimators;       // Independent colorings, each one counted by its own triplets
+	bool     is_incremental;      // Add the edges to the samples of the previous incremental job, if it is compatible
+	bool     has_deletions;       // Fully dynamic graph, whose "-u v" lines delete an edge
+	uint64_t window_size;         // Count the last window_size edges (or time units) of the graph. 0 if not used
+	bool     is_time_window;      // The window and its period are in time units of the timestamps of the edges
+	uint64_t window_period;       // Between two counts of the window. The window size if 0
+	char*    local_counts_path;   // File of the triangles and clustering coefficient of each node. NULL if not written
+
+	const edge_t* edges;    // Graph in memory, read instead of the file if not NULL. It is not modified
+	uint64_t      nr_edges; // Edges of the graph in memory
+	bool          is_quiet; // Do not print the progress
+} count_job_t;
+
+// Count of a sliding window at the end of a period
+typedef struct {
+	uint64_t end;       // Edges read, or timestamp, at the end of the period
+	uint64_t edges;     // Edges in the window
+	uint64_t triangles; // Median of means of the estimators
+} window_estimate_t;
+
+// Counts and timings of a job
+typedef struct {
+	uint64_t triangles;      // Median of means of the estimators
+	double*  estimations;    // Triangles of each estimator
+	uint32_t nr_estimators;
+	double   interval_low;   // Confidence interval of the median of means. Empty with a single estimator
+	double   interval_high;
+	uint64_t edges_in_graph; // Without the dropped duplicates and self-loops, and the deleted edges
+	uint64_t edges_kept;     // Kept by the uniform sampling
+	uint32_t nr_rounds;
+	double   load_ratio;     // Max over mean of the edges received by the DPUs
+	uint32_t nr_increments;  // Incremental jobs whose edges are in the samples. 0 if the job is not incremental
+
+	// Counts of the sliding window at the end of each period. The window at the end of the graph is the result
+	window_estimate_t* windows;
+	uint32_t           nr_windows;
+
+	uint64_t local_count_nodes; // Nodes written to the file of the local counts. 0 if not written
+
+	float setup_time; // Milliseconds
+	float sample_creation_time;
+	float counting_time;
+} count_result_t;
+
+// DPUs allocated and loaded once, and used by all the jobs
+typedef struct {
+	struct dpu_set_t dpu_set;
+	uint32_t         nr_dpus;
+	uint32_t         nr_tasklets;
+
+	dpu_allocation_args_t allocation_args; // Used by the allocation thread
+	pthread_t             allocation_thread;
+	bool                  is_allocating;   // The allocation thread was not joined yet
+	float                 allocation_time; // Milliseconds spent allocating in the calling thread. Part of the setup
+	bool                  is_used;         // The DPUs must be reset before the next job
+
+	// Samples kept on the DPUs by the incremental jobs. The next incremental job with the same sampling parameters adds
+	// its edges to them instead of resetting the DPUs
+	uint32_t    nr_increments;  // Incremental jobs whose edges are in the samples. 0 if there are no samples to extend
+	count_job_t sampling_job;   // First incremental job of the samples
+	uint32_t*   colorings;      // Coloring chosen for each estimator by the first job
+	uint64_t    edges_in_graph; // Edges of all the incremental jobs
+	uint64_t    edges_kept;
+	uint32_t    max_node_id;
+} dpu_context_t;
+
+// Default parameters of the command line
+void init_count_job(count_job_t* job);
+
+// Set the parameter of a command line option (without the dash). Returns false and writes the error if the option is
+// not a parameter of a job or the value is invalid. The strings are referenced, not copied
+bool set_count_job_option(count_job_t* job, char option, char* value, char* error);
+
+// Triplets of the colors of all the estimators
+uint32_t get_count_job_triplets(const count_job_t* job);
+
+// Check the parameters of the job, before using the DPUs. Some parameters are adjusted, as on the command line.
+// Returns false and writes the error if the job cannot be run on nr_dpus DPUs
+bool check_count_job(count_job_t* job, uint32_t nr_dpus, char* error);
+
+// Allocate the DPUs and load the kernel. With in_background, the allocation is done by another thread, and the first
+// job waits for it only before launching the DPUs
+void create_dpu_context(dpu_context_t* context, uint32_t nr_dpus, uint32_t nr_tasklets, bool in_background);
+
+void delete_dpu_context(dpu_context_t* context);
+
+// Count the triangles of a checked job on the DPUs of the context, printing the progress. The DPUs are reset if a
+// previous job used them, unless both jobs are incremental with the same sampling parameters: the edges are then added
+// to the samples, and the triangles of all the incremental jobs are counted. Returns false and writes the error if the
+// job cannot be run with the memory available
+bool run_count_job(count_job_t* job, dpu_context_t* context, count_result_t* result, char* error);
+
+void delete_count_result(count_result_t* result);
+
+#endif /* __COUNT_JOB_H__ */
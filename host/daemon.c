@@ -0,0 +1,181 @@
+#include <poll.h>       // Wait for the requests with a timeout
+#include <signal.h>     // Ignore the clients that disconnect
+#include <stdbool.h>    // Booleans
+#include <stdint.h>     // Fixed size integers
+#include <stdio.h>      // Print
+#include <stdlib.h>     // Exit
+#include <string.h>     // Split the requests
+#include <sys/socket.h> // Unix sockets
+#include <sys/time.h>   // Request timeout
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "count_job.h"
+#include "daemon.h"
+
+// Read a line from the client. Returns false and writes the error if the connection is closed before the end of the
+// line, if the line does not fit in the request, or if it is not received within DAEMON_REQUEST_TIMEOUT milliseconds
+static bool read_request(int client_fd, char* request, char* error) {
+	struct timeval start, now;
+	gettimeofday(&start, 0);
+
+	uint32_t length = 0;
+	while (length < DAEMON_REQUEST_SIZE - 1) {
+		// The jobs are served one at a time, a client that does not send its request must not stall the next ones
+		gettimeofday(&now, 0);
+		int           remaining_time = DAEMON_REQUEST_TIMEOUT - (int)timedifference_msec(start, now);
+		struct pollfd client         = {.fd = client_fd, .events = POLLIN};
+		if (remaining_time <= 0 || poll(&client, 1, remaining_time) <= 0) {
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "The request was not received within %d ms.",
+			         DAEMON_REQUEST_TIMEOUT);
+			return false;
+		}
+
+		ssize_t nr_read = read(client_fd, &request[length], DAEMON_REQUEST_SIZE - 1 - length);
+		if (nr_read <= 0) {
+			break;
+		}
+
+		char* end = memchr(&request[length], '\n', nr_read);
+		length += nr_read;
+		if (end != NULL) {
+			*end = '\0';
+			return true;
+		}
+	}
+
+	snprintf(error, COUNT_JOB_ERROR_SIZE, "The request must be a line of at most %d characters.",
+	         DAEMON_REQUEST_SIZE - 1);
+	return false;
+}
+
+// Set the options of the request. Returns false and writes the error if the request is not valid
+static bool parse_request(char* request, count_job_t* job, char* error) {
+	char* save_ptr;
+	char* option = strtok_r(request, " \t\r", &save_ptr);
+	while (option != NULL) {
+		char* value = strtok_r(NULL, " \t\r", &save_ptr);
+		if (option[0] != '-' || strlen(option) != 2 || value == NULL) {
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "Wrong argument: %s", option);
+			return false;
+		}
+
+		// The DPUs and the kernel are the ones of the daemon
+		if (strchr("dDlLjJ", option[1]) != NULL) {
+			snprintf(error, COUNT_JOB_ERROR_SIZE, "%s can only be given to the daemon.", option);
+			return false;
+		}
+
+		if (!set_count_job_option(job, option[1], value, error)) {
+			return false;
+		}
+
+		option = strtok_r(NULL, " \t\r", &save_ptr);
+	}
+
+	if (strcmp(job->filename, "-") == 0) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "The daemon cannot read a graph from its standard input.");
+		return false;
+	}
+
+	return true;
+}
+
+static void write_error(int client_fd, const char* error) {
+	// The messages can hold the values of the request, so the quotes, the backslashes and the control characters are
+	// escaped to keep the JSON valid
+	dprintf(client_fd, "{\"error\": \"");
+	for (const unsigned char* c = (const unsigned char*)error; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			dprintf(client_fd, "\\%c", *c);
+		} else if (*c < 0x20) {
+			dprintf(client_fd, "\\u%04x", *c);
+		} else {
+			dprintf(client_fd, "%c", *c);
+		}
+	}
+	dprintf(client_fd, "\"}\n");
+}
+
+static void write_result(int client_fd, const count_result_t* result) {
+	dprintf(client_fd, "{\"triangles\": %lu, \"estimators\": [", result->triangles);
+	for (uint32_t estimator = 0; estimator < result->nr_estimators; estimator++) {
+		dprintf(client_fd, (estimator == 0) ? "%.0f" : ", %.0f", result->estimations[estimator]);
+	}
+	dprintf(client_fd, "], \"confidence_interval\": [%.0f, %.0f], ", result->interval_low, result->interval_high);
+	dprintf(client_fd, "\"edges\": %lu, \"edges_kept\": %lu, \"rounds\": %u, \"increments\": %u, \"load_ratio\": %f, ",
+	        result->edges_in_graph, result->edges_kept, result->nr_rounds, result->nr_increments, result->load_ratio);
+	dprintf(client_fd, "\"local_count_nodes\": %lu, ", result->local_count_nodes);
+	dprintf(client_fd, "\"windows\": [");
+	for (uint32_t window = 0; window < result->nr_windows; window++) {
+		dprintf(client_fd, "%s{\"end\": %lu, \"edges\": %lu, \"triangles\": %lu}", (window == 0) ? "" : ", ",
+		        result->windows[window].end, result->windows[window].edges, result->windows[window].triangles);
+	}
+	dprintf(client_fd, "], ");
+	dprintf(client_fd, "\"setup_time\": %f, \"sample_creation_time\": %f, \"counting_time\": %f}\n",
+	        result->setup_time, result->sample_creation_time, result->counting_time);
+}
+
+void run_daemon(const char* socket_path, dpu_context_t* context, const count_job_t* default_job) {
+	struct sockaddr_un address = {.sun_family = AF_UNIX};
+	if (strlen(socket_path) >= sizeof(address.sun_path)) {
+		printf("The path of the socket is too long.\n");
+		exit(1);
+	}
+	strcpy(address.sun_path, socket_path);
+
+	int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server_fd < 0) {
+		printf("Cannot create the socket.\n");
+		exit(1);
+	}
+
+	// A socket left by a previous daemon would make bind fail
+	unlink(socket_path);
+	if (bind(server_fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(server_fd, SOMAXCONN) != 0) {
+		printf("Cannot listen on the socket %s.\n", socket_path);
+		exit(1);
+	}
+
+	// Writing to a client that closed the connection must not stop the daemon
+	signal(SIGPIPE, SIG_IGN);
+
+	printf("Waiting for jobs on %s, with %u DPUs\n", socket_path, context->nr_dpus);
+	fflush(stdout);
+
+	char request[DAEMON_REQUEST_SIZE];
+	char error[COUNT_JOB_ERROR_SIZE];
+	bool is_running = true;
+	while (is_running) {
+		int client_fd = accept(server_fd, NULL, NULL);
+		if (client_fd < 0) {
+			continue;
+		}
+
+		if (!read_request(client_fd, request, error)) {
+			write_error(client_fd, error);
+		} else if (strcmp(request, "quit") == 0) {
+			dprintf(client_fd, "{}\n");
+			is_running = false;
+		} else {
+			printf("Job: %s\n", request);
+
+			count_job_t    job = *default_job;
+			count_result_t result;
+			if (!parse_request(request, &job, error) || !check_count_job(&job, context->nr_dpus, error) ||
+			    !run_count_job(&job, context, &result, error)) {
+				printf("%s\n", error);
+				write_error(client_fd, error);
+			} else {
+				write_result(client_fd, &result);
+				delete_count_result(&result);
+			}
+			fflush(stdout);
+		}
+
+		close(client_fd);
+	}
+
+	close(server_fd);
+	unlink(socket_path);
+}
@@ -0,0 +1,19 @@
+#ifndef __DAEMON_H__
+#define __DAEMON_H__
+
+#include "count_job.h"
+
+// Max length of a request, including the newline
+#define DAEMON_REQUEST_SIZE 4096
+
+// Milliseconds given to a client to send its request, after which the connection is closed
+#define DAEMON_REQUEST_TIMEOUT 5000
+
+// Serve the jobs sent to the Unix socket, one at a time, on the DPUs of the context. A request is a line with the
+// options of a job, as on the command line (for example "-f graph.txt -s 1 -c 8"). The options that are not given take
+// the values of default_job. The daemon answers with a line holding a JSON object, with the counts and the timings of
+// the job or with an error, and closes the connection. The requests sent while a job is running wait in the backlog
+// of the socket. The request "quit" stops the daemon
+void run_daemon(const char* socket_path, dpu_context_t* context, const count_job_t* default_job);
+
+#endif /* __DAEMON_H__ */
@@ -0,0 +1,117 @@
+#include <math.h>    // Compare p to 1
+#include <pthread.h> // Threads
+#include <stdatomic.h>
+#include <stdbool.h>  // Booleans
+#include <stdint.h>   // Fixed size integers
+#include <stdio.h>    // Print
+#include <stdlib.h>   // Various
+#include <sys/mman.h> // Allocate the degrees
+
+#include "../common/common.h"
+#include "chunk_scheduler.h"
+#include "coo_parser.h"
+#include "degree_order.h"
+#include "edge_set.h"
+#include "host_util.h"
+
+_Atomic uint32_t* create_degrees(uint32_t max_node_id) {
+
+	// Anonymous pages are zeroed by the kernel. MAP_NORESERVE allows reserving the full range of node ids
+	_Atomic uint32_t* degrees =
+	    (_Atomic uint32_t*)mmap(0, ((uint64_t)max_node_id + 1) * sizeof(uint32_t), PROT_READ | PROT_WRITE,
+	                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (degrees == MAP_FAILED) {
+		printf("Cannot allocate the degrees of the nodes.\n");
+		exit(1);
+	}
+
+	return degrees;
+}
+
+void delete_degrees(_Atomic uint32_t* degrees, uint32_t max_node_id) {
+	munmap((void*)degrees, ((uint64_t)max_node_id + 1) * sizeof(uint32_t));
+}
+
+static inline void count_edge(count_degrees_args_t* args, edge_t edge) {
+	uint32_t max_node = (edge.u > edge.v) ? edge.u : edge.v;
+	if (max_node > args->max_node_id) {
+		args->max_node_id = max_node;
+	}
+
+	// The degrees are the ones of the graph sent to the DPUs, without the edges dropped by -u and -p
+	edge_t ordered_edge = (edge.u < edge.v) ? edge : (edge_t){edge.v, edge.u};
+	if (args->edge_set != NULL &&
+	    (edge.u == edge.v || insert_edge_into_set(args->edge_set, ordered_edge) == EDGE_DUPLICATE)) {
+		return;
+	}
+	if (fabs(args->p - 1.0) > EPSILON && edge_sampling_value(ordered_edge, args->seed) >= args->p) {
+		return;
+	}
+
+	atomic_fetch_add_explicit(&args->degrees[edge.u], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&args->degrees[edge.v], 1, memory_order_relaxed);
+}
+
+void* count_degrees(void* args_thread) {
+
+	count_degrees_args_t* args = (count_degrees_args_t*)args_thread;
+
+	// The chunks are the same used later to create the batches
+	input_chunk_t chunk;
+	while (get_next_chunk(args->scheduler, args->th_id, &chunk)) {
+
+		if (args->binary_edges != NULL) {
+			for (uint64_t edge_index = chunk.from; edge_index < chunk.to; edge_index++) {
+				count_edge(args, args->binary_edges[edge_index]);
+			}
+		} else {
+			uint64_t file_char_counter = chunk.from;
+			while (file_char_counter < chunk.to) {
+				edge_t current_edge;
+				bool   is_valid_edge;
+				file_char_counter = parse_coo_line(args->mmaped_file, file_char_counter, args->file_size,
+				                                   &current_edge, &is_valid_edge);
+
+				if (is_valid_edge) {
+					count_edge(args, current_edge);
+				}
+			}
+		}
+	}
+
+	pthread_exit(NULL);
+}
+
+uint32_t rank_nodes_by_degree(_Atomic uint32_t* degrees, uint32_t max_node_id) {
+
+	// Counting sort by degree. Nodes with the same degree keep the order of their ids
+	uint32_t max_degree = 0;
+	for (uint64_t node_id = 0; node_id <= max_node_id; node_id++) {
+		uint32_t degree = atomic_load_explicit(&degrees[node_id], memory_order_relaxed);
+		max_degree      = (degree > max_degree) ? degree : max_degree;
+	}
+
+	uint32_t* first_rank = (uint32_t*)calloc((uint64_t)max_degree + 1, sizeof(uint32_t));
+	for (uint64_t node_id = 0; node_id <= max_node_id; node_id++) {
+		first_rank[atomic_load_explicit(&degrees[node_id], memory_order_relaxed)]++;
+	}
+
+	// The nodes with degree 0 are not part of the graph, the ranks start from the nodes with degree 1
+	uint32_t nr_nodes = 0;
+	for (uint64_t degree = 1; degree <= max_degree; degree++) {
+		uint32_t nodes_with_degree = first_rank[degree];
+		first_rank[degree]         = nr_nodes;
+		nr_nodes += nodes_with_degree;
+	}
+
+	for (uint64_t node_id = 0; node_id <= max_node_id; node_id++) {
+		uint32_t degree = atomic_load_explicit(&degrees[node_id], memory_order_relaxed);
+		if (degree > 0) {
+			atomic_store_explicit(&degrees[node_id], first_rank[degree]++, memory_order_relaxed);
+		}
+	}
+
+	free(first_rank);
+
+	return nr_nodes;
+}
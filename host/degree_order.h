@@ -0,0 +1,45 @@
+#ifndef __DEGREE_ORDER_H__
+#define __DEGREE_ORDER_H__
+
+#include <stdatomic.h>
+#include <stdint.h> // Fixed size integers
+
+#include "../common/common.h"
+#include "chunk_scheduler.h"
+#include "edge_set.h"
+
+// First pass of the degree ordering: count the degree of every node of the graph, with the edges that the second pass
+// sends to the DPUs
+typedef struct {
+	uint32_t th_id;
+
+	// Same input as the threads creating the batches. binary_edges is NULL if the file is in COO format
+	char*              mmaped_file;
+	uint64_t           file_size;
+	const edge_t*      binary_edges;
+	chunk_scheduler_t* scheduler;
+
+	// Same filters as the threads creating the batches. edge_set is NULL if the duplicates are not dropped, and it must
+	// be reset before the second pass
+	edge_set_t* edge_set;
+	int32_t     seed;
+	double      p;
+
+	_Atomic uint32_t* degrees; // Shared by all the threads
+	uint32_t          max_node_id;
+} count_degrees_args_t;
+
+// Allocate the degrees of the nodes up to max_node_id, all 0. The pages are only allocated when touched, so
+// UINT32_MAX can be used if the max node id is not known
+_Atomic uint32_t* create_degrees(uint32_t max_node_id);
+
+void delete_degrees(_Atomic uint32_t* degrees, uint32_t max_node_id);
+
+// Function executed by each thread counting the degrees
+void* count_degrees(void* args_thread);
+
+// Replace the degree of each node with its rank by (degree, id), so that the nodes with lower degree get lower ids.
+// Nodes with degree 0 do not appear in the graph and are not ranked. Returns the number of ranked nodes
+uint32_t rank_nodes_by_degree(_Atomic uint32_t* degrees, uint32_t max_node_id);
+
+#endif /* __DEGREE_ORDER_H__ */
@@ -0,0 +1,392 @@
+#include <dpu.h>
+#include <pthread.h> // Mutexes and condition variables
+#include <sched.h>   // Yield while a chunk is replaced
+#include <stdatomic.h>
+#include <stdbool.h>  // Booleans
+#include <stdint.h>   // Fixed size integers
+#include <stdlib.h>   // Various
+#include <sys/time.h> // Measure blocked time
+
+#include "../common/common.h"
+#include "batch_cache.h"
+#include "batch_pool.h"
+#include "dpu_sender.h"
+#include "host_util.h"
+
+// A launch of the DPUs of a rank. The buffers must stay valid until the asynchronous transfers are done
+typedef struct {
+	batch_pool_t* pool;
+	uint32_t      sent_chunks;     // Chain of all the chunks transferred for the launch
+	uint64_t*     edges_in_launch; // Edges processed by each DPU of the rank
+} dpu_transfer_t;
+
+// Make the chunk the current one of the batch, with no edges
+static inline void set_staging_chunk(dpu_sender_t* sender, uint32_t dpu_id, uint32_t chunk) {
+	atomic_store_explicit(&sender->written_edges[chunk], 0, memory_order_relaxed);
+	atomic_store_explicit(&sender->staging[dpu_id].current, (uint64_t)chunk << 32, memory_order_release);
+}
+
+void create_dpu_sender(dpu_sender_t* sender, struct dpu_set_t dpu_set, uint32_t first_triplet, uint32_t nr_batches,
+                       batch_pool_t* pool, uint32_t nr_producers, batch_cache_t* batch_cache) {
+	sender->nr_batches    = nr_batches;
+	sender->first_triplet = first_triplet;
+	sender->pool          = pool;
+	sender->nr_producers  = nr_producers;
+	sender->is_closed     = false;
+	sender->batch_cache   = batch_cache;
+	sender->nr_launches   = 0;
+	sender->written_edges = (atomic_uint*)malloc(pool->nr_chunks * sizeof(atomic_uint));
+
+	sender->staging = (dpu_staging_t*)aligned_alloc(alignof(dpu_staging_t), nr_batches * sizeof(dpu_staging_t));
+	for (uint32_t dpu_id = 0; dpu_id < nr_batches; dpu_id++) {
+		dpu_staging_t* staging     = &sender->staging[dpu_id];
+		staging->first_ready_chunk = BATCH_POOL_NONE;
+		staging->last_ready_chunk  = BATCH_POOL_NONE;
+		staging->nr_ready_chunks   = 0;
+		staging->last_ready_edges  = 0;
+		staging->edges_sent        = 0;
+
+		// The chunks of the last launches of a previous round come back when the DPUs are done with them
+		set_staging_chunk(sender, dpu_id, take_chunk(pool));
+	}
+
+	DPU_ASSERT(dpu_get_nr_ranks(dpu_set, &sender->nr_ranks));
+	sender->ranks      = (struct dpu_set_t*)malloc(sender->nr_ranks * sizeof(struct dpu_set_t));
+	sender->first_dpus = (uint32_t*)malloc((sender->nr_ranks + 1) * sizeof(uint32_t));
+
+	// The DPUs of the set are numbered rank after rank
+	struct dpu_set_t rank;
+	uint32_t         rank_id;
+	uint32_t         nr_dpus = 0;
+	DPU_RANK_FOREACH(dpu_set, rank, rank_id) {
+		uint32_t nr_rank_dpus;
+		DPU_ASSERT(dpu_get_nr_dpus(rank, &nr_rank_dpus));
+
+		sender->ranks[rank_id]      = rank;
+		sender->first_dpus[rank_id] = nr_dpus;
+		nr_dpus += nr_rank_dpus;
+	}
+	sender->first_dpus[sender->nr_ranks] = nr_dpus;
+
+	sender->rank_rounds  = (uint32_t*)malloc(sender->nr_ranks * sizeof(uint32_t));
+	sender->first_chunks = (uint32_t*)malloc(nr_batches * sizeof(uint32_t));
+	sender->edge_counts  = (uint64_t*)malloc(nr_batches * sizeof(uint64_t));
+
+	pthread_mutex_init(&sender->mutex, NULL);
+	pthread_cond_init(&sender->chunk_ready, NULL);
+	pthread_mutex_init(&sender->send_mutex, NULL);
+}
+
+void delete_dpu_sender(dpu_sender_t* sender) {
+	free(sender->staging);
+	free(sender->written_edges);
+	free(sender->ranks);
+	free(sender->first_dpus);
+	free(sender->rank_rounds);
+	free(sender->first_chunks);
+	free(sender->edge_counts);
+
+	pthread_mutex_destroy(&sender->mutex);
+	pthread_cond_destroy(&sender->chunk_ready);
+	pthread_mutex_destroy(&sender->send_mutex);
+}
+
+// Add a chunk at the end of the full chunks of the batch. The sender mutex must be held
+static void add_ready_chunk(dpu_sender_t* sender, uint32_t dpu_id, uint32_t chunk, uint64_t nr_edges) {
+	dpu_staging_t* staging = &sender->staging[dpu_id];
+
+	sender->pool->next[chunk] = BATCH_POOL_NONE;
+	if (staging->first_ready_chunk == BATCH_POOL_NONE) {
+		staging->first_ready_chunk = chunk;
+	} else {
+		sender->pool->next[staging->last_ready_chunk] = chunk;
+	}
+	staging->last_ready_chunk = chunk;
+	staging->last_ready_edges = nr_edges;
+	staging->nr_ready_chunks++;
+}
+
+float wait_staging_chunk(dpu_sender_t* sender, uint32_t dpu_id) {
+	struct timeval start_wait, end_wait;
+	gettimeofday(&start_wait, 0);
+
+	// Only the count is checked: the same chunk may come back to the batch before this thread sees the new one
+	while ((uint32_t)atomic_load_explicit(&sender->staging[dpu_id].current, memory_order_acquire) >=
+	       sender->pool->chunk_edges) {
+		sched_yield();
+	}
+
+	gettimeofday(&end_wait, 0);
+	return timedifference_msec(start_wait, end_wait);
+}
+
+void close_dpu_sender(dpu_sender_t* sender) {
+	pthread_mutex_lock(&sender->mutex);
+
+	// The current chunks are sent even if they are not full
+	for (uint32_t dpu_id = 0; dpu_id < sender->nr_batches; dpu_id++) {
+		uint64_t current  = atomic_load_explicit(&sender->staging[dpu_id].current, memory_order_relaxed);
+		uint32_t chunk    = current >> 32;
+		uint64_t nr_edges = (uint32_t)current;
+
+		if (nr_edges > 0) {
+			add_ready_chunk(sender, dpu_id, chunk, nr_edges);
+		} else {
+			sender->pool->next[chunk] = BATCH_POOL_NONE;
+			release_chunks(sender->pool, chunk);
+		}
+	}
+
+	sender->is_closed = true;
+	pthread_cond_signal(&sender->chunk_ready);
+	pthread_mutex_unlock(&sender->mutex);
+}
+
+// Called when the DPUs of a rank are done with a launch, so its chunks are not needed anymore
+static dpu_error_t release_transfer(struct dpu_set_t dpu_set, uint32_t rank_id, void* transfer_ptr) {
+	(void)dpu_set;
+	(void)rank_id;
+
+	dpu_transfer_t* transfer = (dpu_transfer_t*)transfer_ptr;
+	release_chunks(transfer->pool, transfer->sent_chunks);
+	free(transfer->edges_in_launch);
+	free(transfer);
+
+	return DPU_OK;
+}
+
+// Chunks sent to each DPU of the rank in the next launch: as many as all the batches of the rank have, so that no DPU
+// receives padding. If is_forced, all the full chunks are sent. Never more than MAX_EDGES_PER_TRANSFER edges, 30MB of
+// the MRAM. The sender mutex must be held
+static uint32_t get_rank_rounds(const dpu_sender_t* sender, uint32_t rank_id, bool is_forced) {
+	uint32_t first_dpu = sender->first_dpus[rank_id];
+	uint32_t last_dpu  = sender->first_dpus[rank_id + 1];
+	last_dpu           = (last_dpu < sender->nr_batches) ? last_dpu : sender->nr_batches;
+
+	if (first_dpu >= last_dpu) {
+		return 0; // No triplets in the rank
+	}
+
+	uint32_t min_ready = UINT32_MAX;
+	uint32_t max_ready = 0;
+	for (uint32_t dpu_id = first_dpu; dpu_id < last_dpu; dpu_id++) {
+		uint32_t nr_ready = sender->staging[dpu_id].nr_ready_chunks;
+		min_ready         = (nr_ready < min_ready) ? nr_ready : min_ready;
+		max_ready         = (nr_ready > max_ready) ? nr_ready : max_ready;
+	}
+
+	uint32_t rounds            = is_forced ? max_ready : min_ready;
+	uint32_t chunks_per_launch = MAX_EDGES_PER_TRANSFER / sender->pool->chunk_edges;
+	return (rounds < chunks_per_launch) ? rounds : chunks_per_launch;
+}
+
+// Detach the first chunks of the batch, at most nr_chunks. Returns the number of edges in them. The sender mutex must
+// be held
+static uint64_t take_ready_chunks(dpu_sender_t* sender, uint32_t dpu_id, uint32_t nr_chunks, uint32_t* first_chunk) {
+	dpu_staging_t* staging = &sender->staging[dpu_id];
+	uint32_t*      next    = sender->pool->next;
+
+	nr_chunks = (nr_chunks < staging->nr_ready_chunks) ? nr_chunks : staging->nr_ready_chunks;
+	if (nr_chunks == 0) {
+		*first_chunk = BATCH_POOL_NONE;
+		return 0;
+	}
+	*first_chunk = staging->first_ready_chunk;
+
+	// All the chunks are full, except the last one of the batch
+	if (nr_chunks == staging->nr_ready_chunks) {
+		uint64_t nr_edges          = (nr_chunks - 1) * sender->pool->chunk_edges + staging->last_ready_edges;
+		staging->first_ready_chunk = BATCH_POOL_NONE;
+		staging->nr_ready_chunks   = 0;
+		return nr_edges;
+	}
+
+	uint32_t last_chunk = staging->first_ready_chunk;
+	for (uint32_t i = 1; i < nr_chunks; i++) {
+		last_chunk = next[last_chunk];
+	}
+	staging->first_ready_chunk = next[last_chunk];
+	staging->nr_ready_chunks -= nr_chunks;
+	next[last_chunk] = BATCH_POOL_NONE;
+
+	return nr_chunks * sender->pool->chunk_edges;
+}
+
+// Send the chains of chunks of the DPUs of the rank in a single launch
+static void send_rank_batches(dpu_sender_t* sender, uint32_t rank_id, uint32_t* first_chunks,
+                              const uint64_t* edge_counts) {
+	batch_pool_t*    pool         = sender->pool;
+	struct dpu_set_t rank         = sender->ranks[rank_id];
+	uint32_t         first_dpu    = sender->first_dpus[rank_id];
+	uint32_t         nr_rank_dpus = sender->first_dpus[rank_id + 1] - first_dpu;
+
+	dpu_transfer_t* transfer  = (dpu_transfer_t*)malloc(sizeof(dpu_transfer_t));
+	transfer->pool            = pool;
+	transfer->sent_chunks     = BATCH_POOL_NONE;
+	transfer->edges_in_launch = (uint64_t*)malloc(nr_rank_dpus * sizeof(uint64_t));
+
+	for (uint32_t dpu_id = 0; dpu_id < nr_rank_dpus; dpu_id++) {
+		bool is_batch                     = first_dpu + dpu_id < sender->nr_batches;
+		transfer->edges_in_launch[dpu_id] = is_batch ? edge_counts[first_dpu + dpu_id] : 0;
+	}
+
+	struct dpu_set_t dpu;
+	uint32_t         dpu_id;
+
+	// In each round, the next chunk of every batch is sent to the same MRAM offset. The batches are contiguous in the
+	// MRAM, as the chunks are full except the last one. The transfers start after the previous launch of the rank is
+	// over
+	for (uint64_t first_edge = 0;; first_edge += pool->chunk_edges) {
+		bool is_round_empty = true;
+
+		DPU_FOREACH(rank, dpu, dpu_id) {
+			uint64_t batch_edges = transfer->edges_in_launch[dpu_id];
+
+			if (first_edge < batch_edges) {
+				uint32_t chunk       = first_chunks[first_dpu + dpu_id];
+				uint64_t chunk_edges = batch_edges - first_edge;
+				chunk_edges          = (chunk_edges < pool->chunk_edges) ? chunk_edges : pool->chunk_edges;
+
+				// Another thread may still be writing in the chunk
+				while (atomic_load_explicit(&sender->written_edges[chunk], memory_order_acquire) < chunk_edges) {
+					sched_yield();
+				}
+				if (sender->batch_cache != NULL) {
+					append_to_batch_cache(sender->batch_cache, sender->first_triplet + first_dpu + dpu_id,
+					                      get_chunk(pool, chunk), chunk_edges);
+				}
+				DPU_ASSERT(dpu_prepare_xfer(dpu, get_chunk(pool, chunk)));
+
+				first_chunks[first_dpu + dpu_id] = pool->next[chunk];
+				pool->next[chunk]                = transfer->sent_chunks;
+				transfer->sent_chunks            = chunk;
+				is_round_empty                   = false;
+			} else {
+				DPU_ASSERT(dpu_prepare_xfer(dpu, pool->empty_chunk));
+			}
+		}
+
+		if (is_round_empty) {
+			break;
+		}
+
+		DPU_ASSERT(dpu_push_xfer(rank, DPU_XFER_TO_DPU, DPU_MRAM_HEAP_POINTER_NAME, first_edge * sizeof(edge_t),
+		                         pool->chunk_edges * sizeof(edge_t), DPU_XFER_ASYNC));
+	}
+
+	// Parallel transfer also for the current batch sizes
+	DPU_FOREACH(rank, dpu, dpu_id) {
+		DPU_ASSERT(dpu_prepare_xfer(dpu, &transfer->edges_in_launch[dpu_id]));
+	}
+	DPU_ASSERT(dpu_push_xfer(rank, DPU_XFER_TO_DPU, "edges_in_batch", 0, sizeof(uint64_t), DPU_XFER_ASYNC));
+
+	DPU_ASSERT(dpu_launch(rank, DPU_ASYNCHRONOUS));
+	sender->nr_launches++;
+
+	// The transfer may be freed as soon as the callback is set
+	for (dpu_id = first_dpu; dpu_id < first_dpu + nr_rank_dpus && dpu_id < sender->nr_batches; dpu_id++) {
+		sender->staging[dpu_id].edges_sent += edge_counts[dpu_id];
+	}
+
+	// The chunks can be used again once the rank is done with the launch. The rank does not wait for the callback
+	DPU_ASSERT(dpu_callback(rank, release_transfer, transfer, DPU_CALLBACK_ASYNC | DPU_CALLBACK_NONBLOCKING));
+}
+
+// Detach the chunks of the next launch of each rank, sender->rank_rounds of them. The sender mutex must be held
+static void take_launch_chunks(dpu_sender_t* sender) {
+	for (uint32_t rank_id = 0; rank_id < sender->nr_ranks; rank_id++) {
+		uint32_t last_dpu = sender->first_dpus[rank_id + 1];
+		last_dpu          = (last_dpu < sender->nr_batches) ? last_dpu : sender->nr_batches;
+
+		for (uint32_t dpu_id = sender->first_dpus[rank_id]; dpu_id < last_dpu; dpu_id++) {
+			sender->edge_counts[dpu_id] =
+			    take_ready_chunks(sender, dpu_id, sender->rank_rounds[rank_id], &sender->first_chunks[dpu_id]);
+		}
+	}
+}
+
+// Only queue the operations of each rank, they are executed in parallel by the ranks
+static void send_launch_chunks(dpu_sender_t* sender) {
+	for (uint32_t rank_id = 0; rank_id < sender->nr_ranks; rank_id++) {
+		if (sender->rank_rounds[rank_id] > 0) {
+			send_rank_batches(sender, rank_id, sender->first_chunks, sender->edge_counts);
+		}
+	}
+}
+
+float replace_staging_chunk(dpu_sender_t* sender, uint32_t dpu_id, uint32_t full_chunk) {
+	struct timeval start_wait, end_wait;
+
+	if (SYNCHRONOUS_SENDS) {
+		gettimeofday(&start_wait, 0);
+		pthread_mutex_lock(&sender->send_mutex);
+
+		pthread_mutex_lock(&sender->mutex);
+		add_ready_chunk(sender, dpu_id, full_chunk, sender->pool->chunk_edges);
+		for (uint32_t rank_id = 0; rank_id < sender->nr_ranks; rank_id++) {
+			sender->rank_rounds[rank_id] = get_rank_rounds(sender, rank_id, true);
+		}
+		take_launch_chunks(sender);
+		pthread_mutex_unlock(&sender->mutex);
+
+		// The chunks are given back to the pool once the DPUs are done with them
+		send_launch_chunks(sender);
+		for (uint32_t rank_id = 0; rank_id < sender->nr_ranks; rank_id++) {
+			DPU_ASSERT(dpu_sync(sender->ranks[rank_id]));
+		}
+		set_staging_chunk(sender, dpu_id, take_chunk(sender->pool));
+
+		pthread_mutex_unlock(&sender->send_mutex);
+		gettimeofday(&end_wait, 0);
+
+		return timedifference_msec(start_wait, end_wait);
+	}
+
+	// The chunk is given to the sender first, so that it can free chunks if the pool is empty
+	pthread_mutex_lock(&sender->mutex);
+	add_ready_chunk(sender, dpu_id, full_chunk, sender->pool->chunk_edges);
+	pthread_cond_signal(&sender->chunk_ready);
+	pthread_mutex_unlock(&sender->mutex);
+
+	gettimeofday(&start_wait, 0);
+	set_staging_chunk(sender, dpu_id, take_chunk(sender->pool));
+	gettimeofday(&end_wait, 0);
+
+	return timedifference_msec(start_wait, end_wait);
+}
+
+void* run_dpu_sender(void* sender_ptr) {
+
+	dpu_sender_t* sender = (dpu_sender_t*)sender_ptr;
+
+	bool is_over = false;
+	while (!is_over) {
+
+		// Wait for a rank with a full chunk in all its batches. If the threads may soon wait for free chunks, or if
+		// there are no more edges, all the chunks are sent. With SYNCHRONOUS_SENDS, the threads send the full chunks
+		pthread_mutex_lock(&sender->mutex);
+		bool is_rank_ready = false;
+		while (true) {
+			bool is_closed = sender->is_closed;
+			bool is_forced = is_closed || get_nr_free_chunks(sender->pool) < sender->nr_producers;
+
+			for (uint32_t rank_id = 0; rank_id < sender->nr_ranks && (is_closed || !SYNCHRONOUS_SENDS); rank_id++) {
+				sender->rank_rounds[rank_id] = get_rank_rounds(sender, rank_id, is_forced);
+				is_rank_ready                = is_rank_ready || sender->rank_rounds[rank_id] > 0;
+			}
+
+			if (is_rank_ready || is_closed) {
+				is_over = !is_rank_ready;
+				break;
+			}
+			pthread_cond_wait(&sender->chunk_ready, &sender->mutex);
+		}
+
+		take_launch_chunks(sender);
+		pthread_mutex_unlock(&sender->mutex);
+
+		send_launch_chunks(sender);
+	}
+
+	pthread_exit(NULL);
+}
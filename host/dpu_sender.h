@@ -0,0 +1,130 @@
+#ifndef __DPU_SENDER_H__
+#define __DPU_SENDER_H__
+
+#include <dpu.h>
+#include <pthread.h>  // Mutexes and condition variables
+#include <stdalign.h> // Align the staging buffers to cache lines
+#include <stdatomic.h>
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+
+#include "../common/common.h"
+#include "batch_cache.h"
+#include "batch_pool.h"
+#include "write_combining.h"
+
+// Baseline of the sender thread, to compare the time blocked of the host threads: with 1, the thread that fills a
+// chunk sends the full chunks of all the batches itself and waits for the DPUs, while the other threads that fill a chunk
+// wait for it on a mutex, as the batches were sent before the sender thread. Built by make sync_sends
+#ifndef SYNCHRONOUS_SENDS
+#define SYNCHRONOUS_SENDS 0
+#endif
+
+// Batch of a DPU, shared by all the threads. The edges are appended to the current chunk, and the full chunks wait for
+// the sender in a chain
+typedef struct {
+	// Current chunk in the high 32 bits, edges reserved in it in the low 32 bits. A thread reserves a cell with a
+	// single atomic increment. The count goes past the chunk size while the chunk is being replaced
+	alignas(64) atomic_uint_fast64_t current;
+
+	// Full chunks, protected by the mutex of the sender. The last one is not full when the input is over
+	uint32_t first_ready_chunk;
+	uint32_t last_ready_chunk;
+	uint32_t nr_ready_chunks;
+	uint64_t last_ready_edges; // Edges in the last ready chunk
+
+	uint64_t edges_sent; // Only used by the sender
+} dpu_staging_t;
+
+// Only the sender thread transfers the batches to the DPUs, so the threads creating the batches never wait for the
+// DPUs. The transfers and the launches are asynchronous and done rank by rank: each rank receives its next batches as
+// soon as it is done with the previous ones, without waiting for the slower ranks. The chunks are given back to the
+// pool by a callback of each rank.
+// A rank is only sent when all its batches have a full chunk, so no DPU receives padding, unless the pool is running
+// out of free chunks
+typedef struct {
+	uint32_t       nr_batches;    // DPUs with a triplet, the others do not receive edges
+	uint32_t       first_triplet; // Triplet of the first DPU. Not 0 if the triplets are counted in several rounds
+	dpu_staging_t* staging;
+	atomic_uint*   written_edges; // Edges already written in each chunk of the pool
+	batch_pool_t*  pool;
+	uint32_t       nr_producers; // Threads appending edges
+
+	struct dpu_set_t* ranks;
+	uint32_t*         first_dpus; // Id of the first DPU of each rank, followed by the number of DPUs
+	uint32_t          nr_ranks;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t  chunk_ready;
+	bool            is_closed; // No more edges will be appended
+
+	// Chunks taken for the next launches, by the thread sending the batches
+	uint32_t*       rank_rounds;  // Chunks sent to each DPU of each rank
+	uint32_t*       first_chunks; // Of each batch
+	uint64_t*       edge_counts;  // Of each batch
+	pthread_mutex_t send_mutex;   // Only used with SYNCHRONOUS_SENDS
+
+	batch_cache_t* batch_cache; // Copy of the batches for the next runs. NULL if not used
+	uint32_t       nr_launches; // Launches of single ranks
+} dpu_sender_t;
+
+// Give a chunk of the pool to the batch of each DPU with a triplet, from first_triplet on. The pool must have at least
+// two chunks per batch. Waits for the chunks still used by a previous sender
+void create_dpu_sender(dpu_sender_t* sender, struct dpu_set_t dpu_set, uint32_t first_triplet, uint32_t nr_batches,
+                       batch_pool_t* pool, uint32_t nr_producers, batch_cache_t* batch_cache);
+
+void delete_dpu_sender(dpu_sender_t* sender);
+
+// Function executed by the sender thread. Sends the full chunks until the sender is closed, then the rest. With
+// SYNCHRONOUS_SENDS, only the rest
+void* run_dpu_sender(void* sender);
+
+// Let the sender thread send the last edges and finish. No thread can be appending edges
+void close_dpu_sender(dpu_sender_t* sender);
+
+// Called by the thread that filled the last cell of the chunk: hand the chunk to the sender and replace it. Returns the
+// milliseconds spent waiting for a free chunk
+float replace_staging_chunk(dpu_sender_t* sender, uint32_t dpu_id, uint32_t full_chunk);
+
+// Wait until the full chunk of the batch is replaced by another thread. Returns the milliseconds spent waiting
+float wait_staging_chunk(dpu_sender_t* sender, uint32_t dpu_id);
+
+// Append the edges to the batch of the DPU. Lock-free, unless the chunk of the batch is full. The time spent waiting
+// for a new chunk is added to blocked_time
+static inline void stage_edges(dpu_sender_t* sender, uint32_t dpu_id, const edge_t* edges, uint32_t nr_edges,
+                               float* blocked_time) {
+	dpu_staging_t* staging     = &sender->staging[dpu_id];
+	uint64_t       chunk_edges = sender->pool->chunk_edges;
+
+	while (nr_edges > 0) {
+		uint64_t current = atomic_fetch_add_explicit(&staging->current, nr_edges, memory_order_acquire);
+		uint32_t chunk   = current >> 32;
+		uint32_t cell    = (uint32_t)current;
+
+		// Exactly one thread reserves the cell just past the end of the chunk. It fills the chunk, then replaces it
+		uint32_t nr_fitting_edges = (cell < chunk_edges) ? chunk_edges - cell : 0;
+		nr_fitting_edges          = (nr_fitting_edges < nr_edges) ? nr_fitting_edges : nr_edges;
+
+		if (nr_fitting_edges > 0) {
+			copy_edges_to_batch(&get_chunk(sender->pool, chunk)[cell], edges, nr_fitting_edges);
+			if (nr_fitting_edges == WC_BUFFER_EDGES) { // Only the full lines use non-temporal stores
+				store_fence();
+			}
+			atomic_fetch_add_explicit(&sender->written_edges[chunk], nr_fitting_edges, memory_order_release);
+		}
+
+		if (cell + nr_edges <= chunk_edges) {
+			return;
+		}
+		if (cell <= chunk_edges) {
+			*blocked_time += replace_staging_chunk(sender, dpu_id, chunk);
+		} else {
+			*blocked_time += wait_staging_chunk(sender, dpu_id);
+		}
+
+		edges += nr_fitting_edges;
+		nr_edges -= nr_fitting_edges;
+	}
+}
+
+#endif /* __DPU_SENDER_H__ */
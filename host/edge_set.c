@@ -0,0 +1,83 @@
+#include <stdatomic.h>
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+#include <stdio.h>   // Print
+#include <stdlib.h>  // Various
+#include <string.h>  // Clear the slots
+
+#include "../common/common.h"
+#include "edge_set.h"
+
+void create_edge_set(edge_set_t* set, uint64_t memory) {
+
+	// Largest power of two number of slots that fits in the given memory
+	uint64_t nr_slots = 1;
+	while (nr_slots * 2 * sizeof(uint64_t) <= memory) {
+		nr_slots *= 2;
+	}
+
+	if (nr_slots < 2) {
+		printf("The memory for the removal of duplicate edges is too small.\n");
+		exit(1);
+	}
+
+	// calloc gets zeroed pages from the kernel, which are only touched when used
+	set->slots = (_Atomic uint64_t*)calloc(nr_slots, sizeof(uint64_t));
+	if (set->slots == NULL) {
+		printf("Cannot allocate the memory for the removal of duplicate edges.\n");
+		exit(1);
+	}
+
+	set->mask      = nr_slots - 1;
+	set->max_edges = nr_slots * EDGE_SET_MAX_LOAD;
+	atomic_init(&set->nr_edges, 0);
+}
+
+void delete_edge_set(edge_set_t* set) {
+	free((void*)set->slots);
+}
+
+void reset_edge_set(edge_set_t* set) {
+	memset((void*)set->slots, 0, (set->mask + 1) * sizeof(uint64_t));
+	atomic_store(&set->nr_edges, 0);
+}
+
+// Spread the keys over the slots (splitmix64 finalizer), consecutive node ids are common
+static inline uint64_t hash_key(uint64_t key) {
+	key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9;
+	key = (key ^ (key >> 27)) * 0x94D049BB133111EB;
+	return key ^ (key >> 31);
+}
+
+edge_set_result_t insert_edge_into_set(edge_set_t* set, edge_t edge) {
+
+	uint64_t key = ((uint64_t)edge.u << 32) | edge.v;
+
+	// Once the set is full, only look for the edge. There are always empty slots, so the probing ends
+	bool is_full = atomic_load_explicit(&set->nr_edges, memory_order_relaxed) >= set->max_edges;
+
+	for (uint64_t slot = hash_key(key) & set->mask;; slot = (slot + 1) & set->mask) {
+		uint64_t current_key = atomic_load_explicit(&set->slots[slot], memory_order_relaxed);
+
+		if (current_key == key) {
+			return EDGE_DUPLICATE;
+		}
+
+		if (current_key == 0) {
+			if (is_full) {
+				return EDGE_NOT_TRACKED;
+			}
+
+			if (atomic_compare_exchange_strong_explicit(&set->slots[slot], &current_key, key, memory_order_relaxed,
+			                                            memory_order_relaxed)) {
+				atomic_fetch_add_explicit(&set->nr_edges, 1, memory_order_relaxed);
+				return EDGE_NEW;
+			}
+
+			// Another thread took the slot in the meantime, maybe with the same edge
+			if (current_key == key) {
+				return EDGE_DUPLICATE;
+			}
+		}
+	}
+}
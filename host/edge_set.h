@@ -0,0 +1,44 @@
+#ifndef __EDGE_SET_H__
+#define __EDGE_SET_H__
+
+#include <stdatomic.h>
+#include <stdint.h> // Fixed size integers
+
+#include "../common/common.h"
+
+// Max fraction of the slots used, so that the probing distance stays short
+#ifndef EDGE_SET_MAX_LOAD
+#define EDGE_SET_MAX_LOAD 0.75
+#endif
+
+// Result of the insertion of an edge into the set
+typedef enum {
+	EDGE_NEW,         // First occurrence of the edge
+	EDGE_DUPLICATE,   // The edge was already in the set
+	EDGE_NOT_TRACKED, // The set is full. The edge may be a duplicate, but it is kept
+} edge_set_result_t;
+
+// Set of edges shared by all the threads, used to drop duplicate edges before they are sent to the DPUs.
+// Open addressing with linear probing over packed 64-bit keys (u << 32 | v, with u < v). Slots are claimed with
+// compare-and-swap, so no locks are needed. The size is fixed at creation, so the memory used is bounded: when the set
+// is full, the edges already inserted are still detected, while new edges are kept without being tracked
+typedef struct {
+	_Atomic uint64_t* slots; // 0 means empty, it is never a valid key because u < v
+	uint64_t          mask;  // Number of slots - 1. The number of slots is a power of two
+
+	uint64_t             max_edges;
+	atomic_uint_fast64_t nr_edges;
+} edge_set_t;
+
+// Create a set using at most memory bytes
+void create_edge_set(edge_set_t* set, uint64_t memory);
+
+void delete_edge_set(edge_set_t* set);
+
+// Remove all the edges, to read the graph again. No thread can be using the set
+void reset_edge_set(edge_set_t* set);
+
+// Insert an edge with u < v. Lock-free, can be called by all the threads
+edge_set_result_t insert_edge_into_set(edge_set_t* set, edge_t edge);
+
+#endif /* __EDGE_SET_H__ */
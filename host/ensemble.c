@@ -0,0 +1,122 @@
+#include <math.h>   // Square root
+#include <stdint.h> // Fixed size integers
+#include <stdlib.h> // Various
+
+#include "ensemble.h"
+
+int32_t get_triplet_multiplier(uint32_t triplet_id, uint32_t colors) {
+	// Add binom(C + 1 - first_color, 2) to the id of a triplet (c, c, c) to find the id of the next one
+	uint32_t same_color_triplet_id = 0;
+	for (uint32_t first_color = 0; first_color < colors && same_color_triplet_id <= triplet_id; first_color++) {
+		if (triplet_id == same_color_triplet_id) {
+			return 2 - (int32_t)colors;
+		}
+		same_color_triplet_id += (colors - first_color) * (colors - first_color + 1) / 2;
+	}
+	return 1;
+}
+
+uint64_t combine_triplet_estimations(const uint64_t* triplet_estimations, uint32_t colors) {
+	uint32_t nr_triplets = colors * (colors + 1) * (colors + 2) / 6;
+
+	uint64_t total_triangle_estimation = 0;
+
+	// First color in the triplet section considered
+	int first_color_in_triplet = 0;
+	// id of the  next triplet (and DPU) that counts the triangle whose nodes are all colored with the same color
+	uint32_t next_same_color_triplet_id = 0;
+
+	for (uint32_t triplet_id = 0; triplet_id < nr_triplets; triplet_id++) {
+
+		int32_t addition_multiplier = 1;
+
+		if (triplet_id == next_same_color_triplet_id) {
+			addition_multiplier = 2 - colors;
+
+			// Add binom(C + 1 - first_color_in_triplet, 2) to the previous id to find what is the id of the next
+			// triplet that counted triangles with nodes of the same color
+			next_same_color_triplet_id +=
+			    0.5 * (colors - first_color_in_triplet) * (colors - first_color_in_triplet + 1);
+			first_color_in_triplet++;
+		}
+
+		total_triangle_estimation += triplet_estimations[triplet_id] * addition_multiplier;
+	}
+
+	return total_triangle_estimation;
+}
+
+uint32_t get_nr_mean_groups(uint32_t nr_estimates) {
+	uint32_t nr_groups = sqrt(nr_estimates);
+	return (nr_groups > 0) ? nr_groups : 1;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+// The means are sorted in place
+static double get_median(double* values, uint32_t nr_values) {
+	qsort(values, nr_values, sizeof(double), compare_doubles);
+	if (nr_values % 2 == 1) {
+		return values[nr_values / 2];
+	}
+	return (values[nr_values / 2 - 1] + values[nr_values / 2]) / 2;
+}
+
+double median_of_means(const double* estimates, uint32_t nr_estimates, uint32_t nr_groups) {
+	double* means = (double*)malloc(nr_groups * sizeof(double));
+
+	uint32_t group_size  = nr_estimates / nr_groups;
+	uint32_t bigger      = nr_estimates % nr_groups; // Groups with one more estimate
+	uint32_t first_index = 0;
+	for (uint32_t group = 0; group < nr_groups; group++) {
+		uint32_t nr_group_estimates = group_size + (group < bigger);
+
+		double sum = 0;
+		for (uint32_t i = first_index; i < first_index + nr_group_estimates; i++) {
+			sum += estimates[i];
+		}
+		means[group] = sum / nr_group_estimates;
+		first_index += nr_group_estimates;
+	}
+
+	double median = get_median(means, nr_groups);
+	free(means);
+
+	return median;
+}
+
+// splitmix64, so that the interval only depends on the seed
+static inline uint64_t next_random(uint64_t* state) {
+	uint64_t x = (*state += 0x9E3779B97F4A7C15);
+	x          = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+	x          = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+	return x ^ (x >> 31);
+}
+
+void get_bootstrap_interval(const double* estimates, uint32_t nr_estimates, uint32_t nr_groups, int32_t seed,
+                            double* low, double* high) {
+	double* resample = (double*)malloc(nr_estimates * sizeof(double));
+	double* medians  = (double*)malloc(ENSEMBLE_BOOTSTRAP_SAMPLES * sizeof(double));
+	uint64_t state   = (uint32_t)seed;
+
+	for (uint32_t sample = 0; sample < ENSEMBLE_BOOTSTRAP_SAMPLES; sample++) {
+		for (uint32_t i = 0; i < nr_estimates; i++) {
+			resample[i] = estimates[next_random(&state) % nr_estimates];
+		}
+		medians[sample] = median_of_means(resample, nr_estimates, nr_groups);
+	}
+
+	qsort(medians, ENSEMBLE_BOOTSTRAP_SAMPLES, sizeof(double), compare_doubles);
+	uint32_t low_index  = (1 - ENSEMBLE_CONFIDENCE) / 2 * ENSEMBLE_BOOTSTRAP_SAMPLES;
+	uint32_t high_index = (1 + ENSEMBLE_CONFIDENCE) / 2 * ENSEMBLE_BOOTSTRAP_SAMPLES;
+	high_index          = (high_index < ENSEMBLE_BOOTSTRAP_SAMPLES) ? high_index : ENSEMBLE_BOOTSTRAP_SAMPLES - 1;
+	*low                = medians[low_index];
+	*high               = medians[high_index];
+
+	free(resample);
+	free(medians);
+}
@@ -0,0 +1,37 @@
+#ifndef __ENSEMBLE_H__
+#define __ENSEMBLE_H__
+
+#include <stdint.h> // Fixed size integers
+
+// Resamples of the estimates used for the confidence interval
+#ifndef ENSEMBLE_BOOTSTRAP_SAMPLES
+#define ENSEMBLE_BOOTSTRAP_SAMPLES 1000
+#endif
+
+// Probability that the interval contains the median of means of the estimators
+#ifndef ENSEMBLE_CONFIDENCE
+#define ENSEMBLE_CONFIDENCE 0.95
+#endif
+
+// Triangles of a coloring, given the estimation of each of its triplets. The triangles with all the nodes of the same
+// color are counted by colors triplets, so the triplets (c, c, c) subtract colors - 1 of them
+uint64_t combine_triplet_estimations(const uint64_t* triplet_estimations, uint32_t colors);
+
+// Multiplier of the triangles of a triplet of a coloring in combine_triplet_estimations: 2 - colors for the triplets
+// (c, c, c), 1 for the others
+int32_t get_triplet_multiplier(uint32_t triplet_id, uint32_t colors);
+
+// Number of groups of the median of means: the square root of the number of estimators, so that both the groups and
+// their size grow with it
+uint32_t get_nr_mean_groups(uint32_t nr_estimates);
+
+// Median of the means of nr_groups groups of consecutive estimates. The first groups have one more estimate if they
+// cannot have the same size
+double median_of_means(const double* estimates, uint32_t nr_estimates, uint32_t nr_groups);
+
+// Percentile bootstrap interval of the median of means: the estimates are resampled with replacement
+// ENSEMBLE_BOOTSTRAP_SAMPLES times, and the interval holds ENSEMBLE_CONFIDENCE of the medians of means
+void get_bootstrap_interval(const double* estimates, uint32_t nr_estimates, uint32_t nr_groups, int32_t seed,
+                            double* low, double* high);
+
+#endif /* __ENSEMBLE_H__ */
@@ -1,25 +1,29 @@
-#include <assert.h>  // Assert
-#include <limits.h>  // Max values
-#include <math.h>    // Round
-#include <pthread.h> // Mutexes
-#include <stdbool.h> // Booleans
-#include <stdint.h>  // Fixed size integers
-#include <stdio.h>   // Standard output for debug functions
-#include <stdlib.h>  // Various things
-#include <stdlib.h>  // Random
+#include <assert.h>   // Assert
+#include <limits.h>   // Max values
+#include <math.h>     // Round
+#include <pthread.h>  // Mutexes
+#include <stdatomic.h>
+#include <stdbool.h>  // Booleans
+#include <stdint.h>   // Fixed size integers
+#include <stdio.h>    // Standard output for debug functions
+#include <stdlib.h>   // Various things
+#include <sys/time.h> // Measure idle time
 
 #include "../common/common.h"
+#include "chunk_scheduler.h"
+#include "coo_parser.h"
+#include "dpu_sender.h"
+#include "edge_set.h"
 #include "handle_edges_parallel.h"
 #include "host_util.h"
-#include "mg_hashtable.h"
+#include "routing.h"
+#include "space_saving.h"
+#include "stream_reader.h"
+#include "write_combining.h"
 
-extern const hash_parameters_t coloring_params; // Set by the main thread
-
-edge_colors_t get_edge_colors(edge_t edge, uint32_t colors) {
-
-	// Color hashing formula: ((a * id + b) % p ) % colors
-	uint32_t color_u = ((coloring_params.a * edge.u + coloring_params.b) % coloring_params.p) % colors;
-	uint32_t color_v = ((coloring_params.a * edge.v + coloring_params.b) % coloring_params.p) % colors;
+edge_colors_t get_edge_colors(const routing_table_t* routing, edge_t edge) {
+	uint32_t color_u = get_node_color(routing, edge.u);
+	uint32_t color_v = get_node_color(routing, edge.v);
 
 	// The colors must be ordered
 	if (color_u < color_v) {
@@ -28,68 +32,78 @@ edge_colors_t get_edge_colors(edge_t edge, uint32_t colors) {
 	return (edge_colors_t){color_v, color_u};
 }
 
-void* handle_edges_file(void* args_thread) {
-
-	create_batches_args_t* args = (create_batches_args_t*)args_thread;
-
-	// Buffer to read each line. Each node can use 10 chars each at max (unsigned integers of 4 bytes)
-	char     char_buffer[32];
-	uint32_t node1, node2;
-
-	char* mmaped_file = args->mmaped_file;
+// Drop duplicates and self-loops, apply uniform sampling, order the nodes of the edge and add it to the block of edges
+// to insert into the batches. A deletion is handled as the edge it deletes, so that it reaches the same DPUs
+static inline void handle_edge(create_batches_args_t* args, edge_t current_edge, bool is_deletion, bool is_normalized,
+                               space_saving_t* top_freq) {
+
+	// The DPUs of the graphs with deletions, and of the windows whose expired edges are deleted, take the node ids
+	// with the bit of EDGE_DELETION_FLAG for deletions. Such edges are dropped, and the first one fails the job
+	bool is_dynamic = args->has_deletions || args->window != NULL;
+	if (is_dynamic && ((current_edge.u | current_edge.v) & EDGE_DELETION_FLAG)) {
+		if (!args->has_invalid_edge) {
+			args->has_invalid_edge = true;
+			args->invalid_edge     = current_edge;
+		}
+		return;
+	}
 
-	uint64_t file_char_counter = args->from_char;
+	// The dropped edges are not part of the graph, so they are not counted
+	if (args->edge_set != NULL) {
+		if (current_edge.u == current_edge.v) {
+			args->self_loops++;
+			return;
+		}
 
-	// If the division makes the thread start in the middle of an edge, skip to the first full edge
-	// The edge skipped will be handled by the thread with previous id
-	if (file_char_counter != 0 && mmaped_file[file_char_counter - 1] != '\n') {
-		for (; file_char_counter < args->to_char; file_char_counter++) {
-			if (mmaped_file[file_char_counter] == '\n') {
-				file_char_counter++;
-				break;
-			}
+		edge_t ordered_edge =
+		    (current_edge.u < current_edge.v) ? current_edge : (edge_t){current_edge.v, current_edge.u};
+		edge_set_result_t result = insert_edge_into_set(args->edge_set, ordered_edge);
+		if (result == EDGE_DUPLICATE) {
+			args->duplicate_edges++;
+			return;
+		}
+		if (result == EDGE_NOT_TRACKED) {
+			args->untracked_edges++;
 		}
 	}
 
-	// Seed used for the local random number generator
-	uint32_t local_seed = args->seed + args->th_id;
+	if (is_deletion) {
+		args->deleted_edges++;
+	} else {
+		args->total_edges_thread++;
+	}
 
-	node_freq_hashtable_t top_freq;
-	if (args->k > 0) {
-		top_freq = create_hashtable(args->k);
+	// The degrees are the ones of the graph, before the uniform sampling
+	if (args->degrees != NULL) {
+		atomic_fetch_add_explicit(&args->degrees[current_edge.u], 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&args->degrees[current_edge.v], 1, memory_order_relaxed);
 	}
 
-	edge_t current_edge;
-	while (file_char_counter < args->to_char) {
+	uint32_t node1 = current_edge.u;
+	uint32_t node2 = current_edge.v;
 
-		// Read the file char by char until EOL
-		uint32_t c = 0;
-		for (; c < sizeof(char_buffer) && file_char_counter < args->file_size; c++) {
-			if (mmaped_file[file_char_counter] == '\n') {
-				file_char_counter++;
-				break;
-			}
-
-			char_buffer[c] = mmaped_file[file_char_counter];
-			file_char_counter++;
+	// The deletion of an edge is kept only if the edge was
+	if (fabs(args->p - 1.0) > EPSILON) { // p != 1  //If uniform sampling is used
+		edge_t ordered_edge = (node1 < node2) ? current_edge : (edge_t){node2, node1};
+		if (edge_sampling_value(ordered_edge, args->seed) >= args->p) {
+			return;
 		}
-		char_buffer[c] = 0; // Without this, some remains of previous edges may be considered
-
-		args->total_edges_thread++;
-
-		if (fabs(args->p - 1.0) > EPSILON) { // p != 1  //If uniform sampling is used
-			float random = (float)rand_r(&local_seed) / ((float)INT_MAX + 1.0);
-			if (random > args->p) {
-				continue;
-			}
 
+		if (is_deletion) {
+			args->deleted_edges_kept++;
+		} else {
 			args->edges_kept++; // Count the number of edges considered
 		}
+	}
 
-		// Each edge is formed by two unsigned integers separated by a space
-		sscanf(char_buffer, "%d %d", &node1, &node2);
+	// The ids are replaced by the ranks by degree, so that edges go from the lower degree node to the higher one
+	if (args->node_ranks != NULL) {
+		node1 = args->node_ranks[node1];
+		node2 = args->node_ranks[node2];
+	}
 
-		// Edges are considered valid from the file (no duplicates, node1 != node2). No additional checks are performed
+	// Without -u, edges are considered valid from the file (no duplicates, node1 != node2)
+	if (!is_normalized) {
 		if (node1 < node2) { // Nodes in edge need to be ordered
 			current_edge = (edge_t){node1, node2};
 
@@ -103,193 +117,258 @@ void* handle_edges_file(void* args_thread) {
 				args->max_node_id = node1;
 			}
 		}
-
-		if (args->k > 0) {
-			update_top_frequency(&top_freq, node1);
-			update_top_frequency(&top_freq, node2);
-		}
-
-		insert_edge_into_batches(current_edge, args->dpu_info_array, args->batch_size, args->colors, args->th_id,
-		                         args->send_to_dpus_mutex, args->dpu_set);
 	}
 
-	send_batches(args->th_id, args->dpu_info_array, args->send_to_dpus_mutex, args->dpu_set);
-
-	if (args->k > 0) {
-		// Select the top 2*t edges to return to the main thread
-		// No need to return all top k if only a few are used
-		for (uint32_t i = 0; i < 2 * args->t; i++) {
-			// Find the maximum element in unsorted array
-			uint32_t max_idx = i;
-			// Consider only valid entries
-			for (uint32_t j = i + 1; j < top_freq.size; j++) {
-				if (top_freq.table[j].frequency > top_freq.table[max_idx].frequency) {
-					max_idx = j;
-				}
-			}
-
-			args->top_freq[i] = top_freq.table[max_idx];
-
-			if (max_idx != i) {
-				node_frequency_t temp   = top_freq.table[max_idx];
-				top_freq.table[max_idx] = top_freq.table[i];
-				top_freq.table[i]       = temp;
-			}
-		}
+	if (args->k > 0 && !is_deletion) {
+		update_space_saving(top_freq, node1);
+		update_space_saving(top_freq, node2);
+	}
 
-		delete_hashtable(&top_freq);
+	// The routing ignores the flag
+	if (is_deletion) {
+		current_edge.u |= EDGE_DELETION_FLAG;
 	}
 
-	pthread_exit(NULL);
+	args->routing_block[args->nr_routing_block_edges++] = current_edge;
+	if (args->nr_routing_block_edges == ROUTING_BLOCK_EDGES) {
+		insert_edges_into_batches(args, args->routing_block, args->nr_routing_block_edges);
+		args->nr_routing_block_edges = 0;
+	}
 }
 
-void insert_edge_into_batches(edge_t current_edge, dpu_info_t* dpu_info_array, uint32_t batch_size, uint32_t colors,
-                              uint32_t th_id, pthread_mutex_t* mutex, struct dpu_set_t* dpu_set) {
-
-	// Given that the current edge has colors (a,b), with a <= b
-	edge_colors_t current_edge_colors = get_edge_colors(current_edge, colors);
-	uint32_t      a                   = current_edge_colors.color_u;
-	uint32_t      b                   = current_edge_colors.color_v;
-
-	// Considering the current way triplets are assigned to a DPU, to find the ids of the DPUs that will
-	// handle the current edge, it is necessary to consider the cases (a, b, c3), (a, c2, b) and (c1, a, b) (not
-	// allowing for duplicates)
+// Delete the edges that leave the window when an edge with the timestamp is added
+static inline void delete_expired_edges(create_batches_args_t* args, uint64_t timestamp, bool is_normalized,
+                                        space_saving_t* top_freq) {
+	edge_t expired_edge;
+	while (pop_expired_window_edge(args->window, timestamp, &expired_edge)) {
+		handle_edge(args, expired_edge, true, is_normalized, top_freq);
+	}
+}
 
-	// For (a, b, c3), the first occurrence has id:
-	// [sum from x = 0 to (a-1) 0.5*(colors - x) * (colors - x + 1)]
-	// + 0.5 * (colors - a) * (colors - a + 1)
-	// - 0.5 * (colors - b) * (colors - b + 1)
+// Read the graph from where the previous thread stopped, until the end of the period of the window. A single thread
+// reads the graph, in order, so that an edge is always deleted after it was inserted
+static void handle_window_edges(create_batches_args_t* args, space_saving_t* top_freq) {
+	sliding_window_t* window        = args->window;
+	bool              is_normalized = args->binary_edges != NULL && args->is_normalized;
+
+	while (true) {
+		// The previous period may have ended in the middle of a chunk
+		if (!window->has_chunk) {
+			if (args->stream_reader != NULL) {
+				window->stream_chunk = get_stream_chunk(args->stream_reader);
+				if (window->stream_chunk == NULL) {
+					break;
+				}
+				window->chunk = (input_chunk_t){.from = 0, .to = window->stream_chunk->size};
+			} else if (!get_next_chunk(args->scheduler, args->th_id, &window->chunk)) {
+				break;
+			}
+			window->position  = window->chunk.from;
+			window->has_chunk = true;
+		}
 
-	// This formula uses different Gauss sums that show up considering the creation of the triplets
-	// After the first occurrence, the other ids are the following (+1) until c3 reaches the number of total colors
-	uint32_t current_dpu_id = round(
-	    (1.0 / 6) * (a * a * a - 3 * a * a * colors + a * (3 * colors * colors - 1) - 3 * b * (b - 2 * colors - 1)));
+		const char* data      = (window->stream_chunk != NULL) ? window->stream_chunk->data : args->mmaped_file;
+		uint64_t    data_size = (window->stream_chunk != NULL) ? window->stream_chunk->size : args->file_size;
+
+		while (window->position < window->chunk.to) {
+			edge_t   current_edge;
+			uint64_t timestamp     = 0;
+			bool     is_valid_edge = true;
+			uint64_t next_position;
+			if (args->binary_edges != NULL) {
+				current_edge  = args->binary_edges[window->position];
+				next_position = window->position + 1;
+			} else if (window->is_timed) {
+				next_position = parse_timed_coo_line(data, window->position, data_size, &current_edge, &is_valid_edge,
+				                                     &timestamp);
+			} else {
+				next_position = parse_coo_line(data, window->position, data_size, &current_edge, &is_valid_edge);
+			}
 
-	for (uint32_t c3 = b; c3 < colors; c3++) { // Varying the third color
+			if (!is_valid_edge) {
+				window->position = next_position;
+				continue;
+			}
 
-		dpu_info_t* current_dpu_info = &dpu_info_array[th_id * NR_DPUS + current_dpu_id];
+			if (window->is_timed) {
+				// The edges older than the previous one are counted as if they came at its time
+				timestamp              = (timestamp > window->last_timestamp) ? timestamp : window->last_timestamp;
+				window->last_timestamp = timestamp;
+
+				// The periods end at the multiples of the period, and the periods without edges are skipped. The edge
+				// starting a new period is read again by the next thread, once the window of the period is counted
+				if (window->nr_inserted == 0) {
+					window->period_end = (timestamp / window->period + 1) * window->period;
+				} else if (timestamp >= window->period_end) {
+					delete_expired_edges(args, window->period_end, is_normalized, top_freq);
+					window->counted_end = window->period_end;
+					window->period_end += ((timestamp - window->period_end) / window->period + 1) * window->period;
+					return;
+				}
+			}
 
-		(current_dpu_info->batch)[(current_dpu_info->edge_count_batch)++] = current_edge;
+			window->position = next_position;
+			delete_expired_edges(args, timestamp, is_normalized, top_freq);
+			push_window_edge(window, current_edge, timestamp);
+			handle_edge(args, current_edge, false, is_normalized, top_freq);
 
-		if (current_dpu_info->edge_count_batch == batch_size) {
-			send_batches(th_id, dpu_info_array, mutex, dpu_set);
+			if (!window->is_timed && window->nr_inserted == window->period_end) {
+				window->counted_end = window->period_end;
+				window->period_end += window->period;
+				return;
+			}
 		}
 
-		current_dpu_id++;
+		if (window->stream_chunk != NULL) {
+			release_stream_chunk(args->stream_reader, window->stream_chunk);
+			window->stream_chunk = NULL;
+		}
+		window->has_chunk = false;
 	}
 
-	// For (a, c2, b), the first occurrence has id:
-	// [sum from x = 0 to (a-1) 0.5*(colors - x) * (colors - x + 1)] + b - a
+	window->is_input_over = true;
+}
 
-	// This formula uses different Gauss sums that show up considering the creation of the triplets
-	// After the first occurrence, the other ids are determined adding (colors - 1 - c2)
+void* handle_edges_file(void* args_thread) {
 
-	current_dpu_id =
-	    round((1.0 / 6) * a * (a * a - 3 * a * (colors + 1) + 3 * colors * colors + 6 * colors + 2) - a + b);
+	create_batches_args_t* args = (create_batches_args_t*)args_thread;
 
-	for (uint32_t c2 = a; c2 <= b; c2++) { // Varying the third color
-		if (c2 != a && c2 != b) {          // Avoid duplicate insertion in triplets (y, y, y)
+	space_saving_t top_freq;
+	if (args->k > 0) {
+		top_freq = create_space_saving(args->k);
+	}
 
-			dpu_info_t* current_dpu_info = &dpu_info_array[th_id * NR_DPUS + current_dpu_id];
+	edge_t routing_block[ROUTING_BLOCK_EDGES];
+	args->routing_block          = routing_block;
+	args->nr_routing_block_edges = 0;
 
-			(current_dpu_info->batch)[(current_dpu_info->edge_count_batch)++] = current_edge;
+	wc_buffers_t wc_buffers;
+	args->wc_buffers = NULL;
+	if (args->sender->nr_batches >= WC_MIN_BATCHES) {
+		create_wc_buffers(&wc_buffers, args->sender->nr_batches);
+		args->wc_buffers = &wc_buffers;
+	}
 
-			if (current_dpu_info->edge_count_batch == batch_size) {
-				send_batches(th_id, dpu_info_array, mutex, dpu_set);
+	if (args->window != NULL) {
+		handle_window_edges(args, &top_freq);
+	} else if (args->stream_reader != NULL) {
+		// Stream: parse the chunks given by the reader thread until the end of the stream
+		stream_chunk_t* chunk;
+		while ((chunk = get_stream_chunk(args->stream_reader)) != NULL) {
+
+			uint64_t chunk_char_counter = 0;
+			edge_t   current_edge;
+			while (chunk_char_counter < chunk->size) {
+				bool is_valid_edge, is_deletion;
+				chunk_char_counter = parse_coo_update(chunk->data, chunk_char_counter, chunk->size, &current_edge,
+				                                      &is_valid_edge, &is_deletion);
+
+				if (is_valid_edge && (!is_deletion || args->has_deletions)) {
+					handle_edge(args, current_edge, is_deletion, false, &top_freq);
+				}
 			}
-		}
 
-		current_dpu_id += colors - 1 - c2;
-	}
-
-	for (uint32_t c1 = 0; c1 <= a; c1++) {
-		if (c1 != b || c1 != a) { // Avoid duplicate insertions in the cases already considered
+			release_stream_chunk(args->stream_reader, chunk);
+		}
+	} else if (args->binary_edges != NULL) {
+		// Binary file: the edges are read directly from the mmapped file, no parsing needed
+		input_chunk_t chunk;
+		while (get_next_chunk(args->scheduler, args->th_id, &chunk)) {
+			for (uint64_t edge_index = chunk.from; edge_index < chunk.to; edge_index++) {
+				edge_t current_edge = args->binary_edges[edge_index];
+
+				// Only the graphs with deletions have the flag, the others can use all the node ids
+				bool is_deletion = args->has_deletions && (current_edge.u & EDGE_DELETION_FLAG);
+				current_edge.u &= is_deletion ? ~EDGE_DELETION_FLAG : UINT32_MAX;
+
+				handle_edge(args, current_edge, is_deletion, args->is_normalized, &top_freq);
+			}
+		}
+	} else {
+		char* mmaped_file = args->mmaped_file;
 
-			// Similar idea as before. This time, (c1, a, b)
-			// [sum from x=0 to c1-1 0.5*(C-x)*(C-x+1)] + 0.5*(C-c1)*(C-c1+1) - 0.5*(C-a)(C-a+1) + b - a
-			current_dpu_id = round(-0.5 * a * a + a * colors - 0.5 * a + b + 0.5 * colors * colors * c1 -
-			                       0.5 * colors * c1 * c1 + (1.0 / 6) * c1 * c1 * c1 - (1.0 / 6) * c1);
+		// The chunks start and end at the beginning of a line, so no edge is split between chunks
+		input_chunk_t chunk;
+		while (get_next_chunk(args->scheduler, args->th_id, &chunk)) {
 
-			dpu_info_t* current_dpu_info = &dpu_info_array[th_id * NR_DPUS + current_dpu_id];
+			uint64_t file_char_counter = chunk.from;
+			edge_t   current_edge;
+			while (file_char_counter < chunk.to) {
 
-			(current_dpu_info->batch)[(current_dpu_info->edge_count_batch)++] = current_edge;
+				// Each edge is formed by two unsigned integers separated by a space. The line is parsed in place
+				bool is_valid_edge, is_deletion;
+				file_char_counter = parse_coo_update(mmaped_file, file_char_counter, args->file_size, &current_edge,
+				                                     &is_valid_edge, &is_deletion);
 
-			if (current_dpu_info->edge_count_batch == batch_size) {
-				send_batches(th_id, dpu_info_array, mutex, dpu_set);
+				// Skip empty lines and comments, and the deletions if the graph is not fully dynamic
+				if (is_valid_edge && (!is_deletion || args->has_deletions)) {
+					handle_edge(args, current_edge, is_deletion, false, &top_freq);
+				}
 			}
-
-			current_dpu_id += (1.0 / 2) * (colors - c1) * (colors - c1 + 1);
 		}
 	}
-}
-
-void send_batches(uint32_t th_id, dpu_info_t* dpu_info_array, pthread_mutex_t* mutex, struct dpu_set_t* dpu_set) {
 
-	// Limit transfers to 30MB
-	uint64_t max_edges_per_transfer = (30 * 1024 * 1024) / sizeof(edge_t);
+	insert_edges_into_batches(args, args->routing_block, args->nr_routing_block_edges);
 
-	// Determine the max amount of edges per batch that this thread needs to send
-	uint32_t max_edges_to_send = 0;
-	for (int dpu_id = 0; dpu_id < NR_DPUS; dpu_id++) {
-		if (max_edges_to_send < dpu_info_array[th_id * NR_DPUS + dpu_id].edge_count_batch) {
-			max_edges_to_send = dpu_info_array[th_id * NR_DPUS + dpu_id].edge_count_batch;
+	// The lines that are not full are appended last
+	if (args->wc_buffers != NULL) {
+		for (uint32_t dpu_id = 0; dpu_id < wc_buffers.nr_batches; dpu_id++) {
+			stage_edges(args->sender, dpu_id, get_wc_buffer(&wc_buffers, dpu_id), wc_buffers.nr_edges[dpu_id],
+			            &args->blocked_time);
 		}
+		delete_wc_buffers(&wc_buffers);
 	}
 
-	for (uint32_t batch_offset = 0; batch_offset < max_edges_to_send; batch_offset += max_edges_per_transfer) {
+	if (args->k > 0) {
+		// Return the top 2*t nodes to the main thread, no need to return all the top k if only a few are used
+		get_top_frequent_nodes(&top_freq, args->top_freq, 2 * args->t);
 
-		// Size of the biggest remaining batch
-		uint32_t max_remaining_edges_to_send = 0;
-		for (int dpu_id = 0; dpu_id < NR_DPUS; dpu_id++) {
-			if (max_remaining_edges_to_send < dpu_info_array[th_id * NR_DPUS + dpu_id].edge_count_batch) {
-				max_remaining_edges_to_send = dpu_info_array[th_id * NR_DPUS + dpu_id].edge_count_batch;
-			}
-		}
+		delete_space_saving(&top_freq);
+	}
 
-		// Send data to the DPUs
-		pthread_mutex_lock(mutex);
+	gettimeofday(&args->end_time, 0); // The thread is idle until all the other threads finish
 
-		// Wait for all the DPUs to finish the previous task.
-		DPU_ASSERT(dpu_sync(*dpu_set));
+	pthread_exit(NULL);
+}
 
-		uint32_t         dpu_id;
-		struct dpu_set_t dpu;
-		DPU_FOREACH(*dpu_set, dpu, dpu_id) {
-			DPU_ASSERT(dpu_prepare_xfer(dpu, &dpu_info_array[th_id * NR_DPUS + dpu_id].batch[batch_offset]));
-		}
+void insert_edges_into_batches(create_batches_args_t* args, const edge_t* edges, uint32_t nr_edges) {
 
-		// If the amount of edges to send is too big, send the most amount of edges possible
-		// If the amount of edges is not too big, send only the remaining edges
-		bool     batch_too_big = max_remaining_edges_to_send > max_edges_to_send;
-		uint32_t edges_to_send = batch_too_big ? max_edges_to_send : max_remaining_edges_to_send;
+	uint32_t dpu_ids_offsets[ROUTING_BLOCK_EDGES];
 
-		DPU_ASSERT(dpu_push_xfer(*dpu_set, DPU_XFER_TO_DPU, DPU_MRAM_HEAP_POINTER_NAME, 0,
-		                         edges_to_send * sizeof(edge_t), DPU_XFER_DEFAULT));
+	// Only the triplets of the current round have a DPU. The others wrap around to big DPU ids
+	uint32_t first_triplet = args->sender->first_triplet;
+	uint32_t nr_batches    = args->sender->nr_batches;
 
-		// Parallel transfer also for the current batch sizes
-		DPU_FOREACH(*dpu_set, dpu, dpu_id) {
+	// The same edges are routed with the coloring of each estimator, to its own triplets
+	for (uint32_t estimator = 0; estimator < args->nr_estimators; estimator++) {
+		const routing_table_t* routing           = &args->routing_tables[estimator];
+		uint32_t               estimator_triplet = estimator * routing->nr_triplets;
 
-			// If less data than the full remaining batch is sent (so the maximum allowed amount of data per transfer)
-			if (dpu_info_array[th_id * NR_DPUS + dpu_id].edge_count_batch > max_edges_to_send) {
-				DPU_ASSERT(dpu_prepare_xfer(dpu, &max_edges_to_send));
-			} else {
-				DPU_ASSERT(dpu_prepare_xfer(dpu, &dpu_info_array[th_id * NR_DPUS + dpu_id].edge_count_batch));
-			}
+		// No triplet of the estimator in the round
+		if (estimator_triplet >= first_triplet + nr_batches ||
+		    estimator_triplet + routing->nr_triplets <= first_triplet) {
+			continue;
 		}
 
-		DPU_ASSERT(dpu_push_xfer(*dpu_set, DPU_XFER_TO_DPU, "edges_in_batch", 0,
-		                         sizeof(dpu_info_array[th_id * NR_DPUS + dpu_id].edge_count_batch), DPU_XFER_DEFAULT));
-
-		DPU_ASSERT(dpu_launch(*dpu_set, DPU_ASYNCHRONOUS));
+		route_edges(routing, edges, nr_edges, dpu_ids_offsets);
 
-		pthread_mutex_unlock(mutex);
+		for (uint32_t i = 0; i < nr_edges; i++) {
+			const uint16_t* dpu_ids = &routing->dpu_ids[dpu_ids_offsets[i]];
 
-		// Update the count for the remaining edges to send
-		for (dpu_id = 0; dpu_id < NR_DPUS; dpu_id++) {
-			uint32_t last_batch_size = dpu_info_array[th_id * NR_DPUS + dpu_id].edge_count_batch;
+			for (uint32_t j = 0; j < routing->colors; j++) {
+				uint32_t dpu_id = estimator_triplet + dpu_ids[j] - first_triplet;
+				if (dpu_id >= nr_batches) {
+					continue;
+				}
 
-			dpu_info_array[th_id * NR_DPUS + dpu_id].edge_count_batch =
-			    last_batch_size >= max_edges_to_send ? last_batch_size - max_edges_to_send : 0;
+				if (args->wc_buffers == NULL) {
+					stage_edges(args->sender, dpu_id, &edges[i], 1, &args->blocked_time);
+				} else if (add_to_wc_buffer(args->wc_buffers, dpu_id, edges[i])) {
+					stage_edges(args->sender, dpu_id, get_wc_buffer(args->wc_buffers, dpu_id), WC_BUFFER_EDGES,
+					            &args->blocked_time);
+					clear_wc_buffer(args->wc_buffers, dpu_id);
+				}
+			}
 		}
 	}
 }
@@ -2,27 +2,49 @@
 #define __HOST_UTIL_H__
 
 #include <dpu.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <sys/time.h>
 
 #include "../common/common.h"
+#include "chunk_scheduler.h"
+#include "dpu_sender.h"
+#include "edge_set.h"
+#include "routing.h"
+#include "sliding_window.h"
+#include "stream_reader.h"
+#include "write_combining.h"
 
 // Allow for files bigger than 4GB
 #define _FILE_OFFSET_BITS 64
 
-typedef struct {
-	edge_t*  batch;            // Pointer to the array containing the edges in the current batch for the DPU
-	uint64_t edge_count_batch; // Current number of edges in the batch for the DPU
-} dpu_info_t;
-
 typedef struct {
 	uint32_t th_id;
 	uint32_t max_node_id;
 
 	// Handle the file
-	char*    mmaped_file; // Information about file
-	uint64_t file_size;
-	uint64_t from_char;
-	uint64_t to_char;
+	char*              mmaped_file; // Information about file
+	uint64_t           file_size;
+	chunk_scheduler_t* scheduler; // Chunks of chars (COO files) or edges (binary files) handled by the threads
+
+	// Binary files. binary_edges is NULL if the file is in COO format
+	const edge_t* binary_edges;
+	bool          is_normalized; // The edges already have u < v
+
+	// Streams (stdin or FIFO). NULL if the file is mmapped
+	stream_reader_t* stream_reader;
+
+	// Removal of duplicate edges and self-loops. NULL if not used
+	edge_set_t* edge_set;
+	uint64_t    duplicate_edges;
+	uint64_t    self_loops;
+	uint64_t    untracked_edges; // Kept without checking, the set was full
+
+	// Rank of each node by degree, used as its new id. NULL if the nodes are not relabeled
+	const uint32_t* node_ranks;
+
+	// Degree of each node in the graph, for the local counts. NULL if the degrees are not counted
+	_Atomic uint32_t* degrees;
 
 	// Uniform sampling
 	int32_t  seed;
@@ -30,32 +52,51 @@ typedef struct {
 	uint32_t edges_kept;
 	uint32_t total_edges_thread;
 
-	// Misra-Gries
+	// Fully dynamic graphs. The deletions are sent to the DPUs with EDGE_DELETION_FLAG. Otherwise they are ignored
+	bool     has_deletions;
+	uint32_t deleted_edges; // Not counted in total_edges_thread
+	uint32_t deleted_edges_kept;
+	bool     has_invalid_edge; // An edge had a node id with the bit of EDGE_DELETION_FLAG, it fails the job
+	edge_t   invalid_edge;     // The first one
+
+	// Sliding window. The edges leaving it are deleted, and the thread stops at the end of each period. NULL if the
+	// whole graph is counted
+	sliding_window_t* window;
+
+	// Space-Saving
 	uint32_t          k;
 	uint32_t          t;
 	node_frequency_t* top_freq;
 
-	/// Create batches
-	uint32_t    batch_size;
-	uint32_t    colors;
-	dpu_info_t* dpu_info_array;
+	// Routing of the edges to the triplets, with the coloring of each estimator
+	const routing_table_t* routing_tables;
+	uint32_t               nr_estimators;
+
+	// Edges waiting to be colored and routed together
+	edge_t*  routing_block;
+	uint32_t nr_routing_block_edges;
 
-	// Send the batches
-	struct dpu_set_t* dpu_set;
-	pthread_mutex_t*  send_to_dpus_mutex;
+	// Routed edges waiting to be appended to the batches, a cache line at a time. NULL with fewer than WC_MIN_BATCHES
+	// batches, the edges are appended one at a time
+	wc_buffers_t* wc_buffers;
+
+	/// Create batches. The batches of the DPUs are shared by the threads and sent by the sender thread
+	dpu_sender_t* sender;
+	float         blocked_time; // Milliseconds spent waiting for a new chunk of the pool in a batch
+
+	// When the thread finished handling its edges
+	struct timeval end_time;
 } create_batches_args_t;
 
 // Get ordered colors of the edge
-edge_colors_t get_edge_colors(edge_t edge, uint32_t colors);
+edge_colors_t get_edge_colors(const routing_table_t* routing, edge_t edge);
 
 // Function executed by each thread handling the edges. The file is read and the edges are inserted in the correct batch
+// (with a sliding window, only until the end of the period)
 void* handle_edges_file(void* args_thread);
 
-// Insert the current edge into the correct batches considering how triplets are assigned to the DPUs
-void insert_edge_into_batches(edge_t current_edge, dpu_info_t* dpu_info_array, uint32_t batch_size, uint32_t colors,
-                              uint32_t th_id, pthread_mutex_t* mutex, struct dpu_set_t* dpu_set);
-
-// Send the full batch to the specific DPU. th_id_to is not included
-void send_batches(uint32_t th_id, dpu_info_t* dpu_info_array, pthread_mutex_t* mutex, struct dpu_set_t* dpu_set);
+// Insert a block of at most ROUTING_BLOCK_EDGES edges into the batches of the DPUs handling them, found with the
+// routing table
+void insert_edges_into_batches(create_batches_args_t* args, const edge_t* edges, uint32_t nr_edges);
 
 #endif /* __HOST_UTIL_H_ */
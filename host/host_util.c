@@ -1,9 +1,12 @@
 #include <assert.h> //Assert
 #include <dpu.h>    //Create DPU set
+#include <limits.h> //Max path length
 #include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>    //Print
 #include <stdlib.h>   //Exit
+#include <string.h>   //Copy the estimations
 #include <sys/time.h> //Measure execution time
 
 #include "host_util.h"
@@ -16,25 +19,116 @@ void usage() {
 	printf(" -M #          [The sample size inside the DPUs is #. Maximum allowed value if not given]\n");
 	printf(" -p #          [Edges are kept with probability #. No edges are ignored (p = 1) if not given]\n");
 
-	printf(" -k #          [The dictionary for Misra-Gries for each thread has a maximum of # entries. Misra-Gries is "
-	       "not used if not given]\n");
-	printf(" -t #          [Send a maximum of # top frequent nodes to the DPUs. Ignored if Misra-Gries is not used. "
+	printf(" -k #          [Each thread finds the top frequent nodes with # Space-Saving counters. The top frequent "
+	       "nodes are not searched if not given]\n");
+	printf(" -t #          [Send a maximum of # top frequent nodes to the DPUs. Ignored if -k is not given. "
 	       "Default value is 5]\n");
 
 	printf(" -c #          [Use # colors to color the nodes of the graph. Required]\n");
-	printf(" -f <filename> [Input Graph in plain COO format. Required]\n");
+	printf(" -f <filename> [Input Graph in plain COO format or in the binary format created by coo_to_bin. "
+	       "Use \"-\" to read a COO graph from the standard input. Required]\n");
+	printf(" -d #          [Use # DPUs. With fewer than the triplets, Binom(colors + 2, 3) for each estimator, the "
+	       "triplets are counted in several rounds. One DPU for each triplet if not given]\n");
+	printf(" -n #          [Use # host threads. Number of online CPUs if not given]\n");
+	printf(" -l #          [Run the DPU kernel compiled for # tasklets (8, 16 or 24). Default value is %d]\n",
+	       DEFAULT_NR_TASKLETS);
+	printf(" -u #          [Drop duplicate edges and self-loops, using at most # MB to find them]\n");
+	printf(" -o <order>    [Node ordering: none, or degree to relabel the nodes by exact degree with an additional "
+	       "pass over the graph (cannot be used with -k). none if not given]\n");
+	printf(" -g #          [Compare # colorings on the start of the graph and use the one with the most balanced load "
+	       "of the DPUs. Default value is 1]\n");
+	printf(" -e #          [Run # independent estimators, each with its own coloring, DPU seed and triplets, and "
+	       "report their median of means with a confidence interval. Default value is 1]\n");
+	printf(" -i <0|1>      [Incremental job: add the edges to the samples of the previous incremental job with "
+	       "the same -s, -M, -p, -t, -c, -g, -e and -r, and count the triangles of all their edges. Only useful "
+	       "with -j]\n");
+	printf(" -r <0|1>      [Fully dynamic graph: the lines \"-u v\" delete the edge u v, and the triangles of the "
+	       "edges left at the end are estimated. The graph is read by a single thread. Default value is 0]\n");
+	printf(" -w #[s]       [Sliding window: count the last # edges, or with s the edges of the last # time units of "
+	       "the timestamps in the third column. The graph is read by a single thread]\n");
+	printf(" -q #          [Count the window every # edges or time units. Default value is the size of the window]\n");
+	printf(" -v <file>     [Write the estimated triangles and clustering coefficient of each node to file, in the "
+	       "binary format of local_counts.h]\n");
+	printf(" -x <dir>      [Cache the edges sent to each DPU in dir, and reuse them in the next runs with the same "
+	       "graph, seed, colors, -p, -u, -o, -g, -e and -r]\n");
+	printf(" -b #          [Use at most # MB of host memory for the batches, the stream buffers and the set of -u. "
+	       "4GB are used for the batches if not given, but no more than 90%% of the free memory]\n");
+	printf(" -j <socket>   [Run as a daemon: allocate the DPUs once and count the graphs of the jobs sent to the Unix "
+	       "socket, one per line with the options of the job. The other options are the defaults of the jobs]\n");
 	exit(1);
 }
 
-void* allocate_dpus(void* dpu_set) {
-	DPU_ASSERT(dpu_alloc(NR_DPUS, NULL, (struct dpu_set_t*)dpu_set));
-	DPU_ASSERT(dpu_load(*(struct dpu_set_t*)dpu_set, DPU_BINARY, NULL));
+void* allocate_dpus(void* allocation_args) {
+	dpu_allocation_args_t* args = (dpu_allocation_args_t*)allocation_args;
 
-	if (NR_THREADS > 1) { // If it's possible to use multiple threads, another thread is used for the allocation
-		pthread_exit(NULL);
-	} else {
-		return NULL;
+	char dpu_binary[PATH_MAX];
+	get_dpu_binary_path(dpu_binary, args->nr_tasklets);
+
+	DPU_ASSERT(dpu_alloc(args->nr_dpus, NULL, args->dpu_set));
+	DPU_ASSERT(dpu_load(*args->dpu_set, dpu_binary, NULL));
+
+	// Returning is valid both from another thread and from the main thread
+	return NULL;
+}
+
+void get_dpu_binary_path(char* dpu_binary, uint32_t nr_tasklets) {
+	snprintf(dpu_binary, PATH_MAX, DPU_BINARY, nr_tasklets);
+}
+
+void setup_dpus(struct dpu_set_t dpu_set, const dpu_arguments_t* input_arguments, uint32_t first_triplet,
+                uint32_t triplets_per_estimator) {
+	uint32_t nr_dpus;
+	DPU_ASSERT(dpu_get_nr_dpus(dpu_set, &nr_dpus));
+	dpu_arguments_t* dpu_arguments = (dpu_arguments_t*)malloc(nr_dpus * sizeof(dpu_arguments_t));
+
+	struct dpu_set_t dpu;
+	uint32_t         dpu_id;
+	DPU_FOREACH(dpu_set, dpu, dpu_id) {
+		dpu_arguments[dpu_id]      = *input_arguments;
+		dpu_arguments[dpu_id].seed = input_arguments->seed + (first_triplet + dpu_id) / triplets_per_estimator;
+		DPU_ASSERT(dpu_prepare_xfer(dpu, &dpu_arguments[dpu_id]));
+	}
+	DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_TO_DPU, "DPU_INPUT_ARGUMENTS", 0, sizeof(dpu_arguments_t),
+	                         DPU_XFER_DEFAULT));
+	free(dpu_arguments);
+
+	DPU_ASSERT(dpu_launch(dpu_set, DPU_ASYNCHRONOUS));
+}
+
+void set_execution_code(struct dpu_set_t dpu_set, uint32_t execution_code, uint32_t max_node_id) {
+	execution_config_t execution_config = {execution_code, max_node_id};
+	DPU_ASSERT(dpu_broadcast_to(dpu_set, "execution_config", 0, &execution_config, sizeof(execution_config),
+	                            DPU_XFER_DEFAULT));
+}
+
+void reset_dpus(struct dpu_set_t dpu_set) {
+	DPU_ASSERT(dpu_sync(dpu_set));
+
+	set_execution_code(dpu_set, 2, 0);
+	DPU_ASSERT(dpu_launch(dpu_set, DPU_SYNCHRONOUS));
+
+	// The next batches are added to the new sample
+	set_execution_code(dpu_set, 0, 0);
+}
+
+void read_triangle_estimations(struct dpu_set_t dpu_set, uint64_t* estimations, uint32_t nr_triplets) {
+	DPU_ASSERT(dpu_sync(dpu_set));
+
+	uint32_t nr_dpus;
+	DPU_ASSERT(dpu_get_nr_dpus(dpu_set, &nr_dpus));
+	uint64_t* dpu_estimations = (uint64_t*)malloc(nr_dpus * sizeof(uint64_t));
+
+	struct dpu_set_t dpu;
+	uint32_t         dpu_id;
+	DPU_FOREACH(dpu_set, dpu, dpu_id) {
+		DPU_ASSERT(dpu_prepare_xfer(dpu, &dpu_estimations[dpu_id]));
 	}
+	DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_FROM_DPU, "triangle_estimation", 0, sizeof(dpu_estimations[0]),
+	                         DPU_XFER_DEFAULT));
+
+	// The DPUs beyond the triplets have no edges
+	memcpy(estimations, dpu_estimations, nr_triplets * sizeof(uint64_t));
+	free(dpu_estimations);
 }
 
 float timedifference_msec(struct timeval t0, struct timeval t1) {
@@ -64,23 +158,46 @@ uint64_t get_free_memory() {
 	return ramKB * 1024; // Return number of bytes
 }
 
-hash_parameters_t get_hash_parameters() {
-	// Determine the parameters used to color the nodes
-	uint32_t p = 8191;                 // Prime number
-	uint32_t a = rand() % (p - 1) + 1; // a in [1, p-1]
-	uint32_t b = rand() % p;           // b in [0, p-1]
+// Min-heap of node frequencies, used to select the top frequent nodes
+static void sift_up(node_frequency_t* heap, uint32_t i) {
+	while (i > 0 && heap[(i - 1) / 2].frequency > heap[i].frequency) {
+		node_frequency_t temp = heap[i];
+		heap[i]               = heap[(i - 1) / 2];
+		heap[(i - 1) / 2]     = temp;
+		i                     = (i - 1) / 2;
+	}
+}
 
-	return (hash_parameters_t){p, a, b};
+static void sift_down(node_frequency_t* heap, uint32_t size, uint32_t i) {
+	while (true) {
+		uint32_t smallest = i;
+		uint32_t left     = 2 * i + 1;
+		uint32_t right    = 2 * i + 2;
+		if (left < size && heap[left].frequency < heap[smallest].frequency) {
+			smallest = left;
+		}
+		if (right < size && heap[right].frequency < heap[smallest].frequency) {
+			smallest = right;
+		}
+		if (smallest == i) {
+			return;
+		}
+
+		node_frequency_t temp = heap[i];
+		heap[i]               = heap[smallest];
+		heap[smallest]        = temp;
+		i                     = smallest;
+	}
 }
 
-uint32_t global_top_freq(node_frequency_t** top_freq_th, node_frequency_t* result_top_f, uint32_t t) {
+uint32_t global_top_freq(node_frequency_t** top_freq_th, uint32_t nr_threads, node_frequency_t* result_top_f,
+                         uint32_t t) {
 
 	// Can hold all the top frequencies from the threads
-	node_freq_hashtable_t top_freq = create_hashtable(NR_THREADS * 2 * t);
+	node_freq_hashtable_t top_freq = create_hashtable(nr_threads * 2 * t);
 
-	uint32_t valid_nodes = 0;
 	// For every top frequent node id in each thread
-	for (uint32_t th_id = 0; th_id < NR_THREADS; th_id++) {
+	for (uint32_t th_id = 0; th_id < nr_threads; th_id++) {
 		for (uint32_t i = 0; i < 2 * t; i++) {
 
 			// The cell is invalid
@@ -89,31 +206,34 @@ uint32_t global_top_freq(node_frequency_t** top_freq_th, node_frequency_t* resul
 			}
 
 			update_global_top_frequency(&top_freq, top_freq_th[th_id][i].node_id, top_freq_th[th_id][i].frequency);
-			valid_nodes++;
 		}
 	}
 
-	// Select the top t edges to return to the main thread
-	// No need to return all top k if only a few are used
-	for (uint32_t i = 0; i < t; i++) {
-		// Find the maximum element in unsorted array
-		uint32_t max_idx = i;
-		for (uint32_t j = i + 1; j < top_freq.size; j++) {
-			if (top_freq.table[j].frequency > top_freq.table[max_idx].frequency) {
-				max_idx = j;
-			}
+	// Keep the t most frequent nodes in a min-heap, the root is the least frequent of them
+	uint32_t heap_size = 0;
+	for (uint32_t i = 0; i < top_freq.size; i++) {
+		if (top_freq.table[i].frequency <= 0) {
+			continue;
 		}
 
-		result_top_f[i] = top_freq.table[max_idx];
-
-		if (max_idx != i) {
-			node_frequency_t temp   = top_freq.table[max_idx];
-			top_freq.table[max_idx] = top_freq.table[i];
-			top_freq.table[i]       = temp;
+		if (heap_size < t) {
+			result_top_f[heap_size++] = top_freq.table[i];
+			sift_up(result_top_f, heap_size - 1);
+		} else if (top_freq.table[i].frequency > result_top_f[0].frequency) {
+			result_top_f[0] = top_freq.table[i];
+			sift_down(result_top_f, heap_size, 0);
 		}
 	}
 
+	// Heapsort: the nodes are returned in order of decreasing frequency
+	for (uint32_t size = heap_size; size > 1; size--) {
+		node_frequency_t temp  = result_top_f[0];
+		result_top_f[0]        = result_top_f[size - 1];
+		result_top_f[size - 1] = temp;
+		sift_down(result_top_f, size - 1, 0);
+	}
+
 	delete_hashtable(&top_freq);
 
-	return (valid_nodes > t ? t : valid_nodes);
+	return heap_size;
 }
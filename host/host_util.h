@@ -1,6 +1,7 @@
 #ifndef __HOST_H__
 #define __HOST_H__
 
+#include <dpu.h>
 #include <stdint.h>
 #include <sys/time.h> //Measure execution time
 
@@ -14,24 +15,79 @@ for every edge 16 bytes are occupied, there can be 63.5MB/16B = 4161536 edges
 #define MAX_SAMPLE_SIZE 4161536
 #endif
 
+// The incremental jobs keep the sample at the end of the MRAM while they count a sorted copy of it, so every edge
+// occupies 24 bytes: 63.5MB/24B = 2774357 edges
+#ifndef MAX_INCREMENTAL_SAMPLE_SIZE
+#define MAX_INCREMENTAL_SAMPLE_SIZE 2774357
+#endif
+
+// With deletions, the DPUs also keep an index of the sample, with two 4 bytes slots for each edge. While counting, the
+// sample and its index are kept with the sorted copy of the sample and the node locations: 63.5MB/32B = 2080768 edges
+#ifndef MAX_DYNAMIC_SAMPLE_SIZE
+#define MAX_DYNAMIC_SAMPLE_SIZE 2080768
+#endif
+
+// The local counts keep a counter of triangles for each edge of the sorted sample, after the node locations, so every
+// edge occupies 24 bytes: 63.5MB/24B = 2774357 edges
+#ifndef MAX_LOCAL_COUNTS_SAMPLE_SIZE
+#define MAX_LOCAL_COUNTS_SAMPLE_SIZE 2774357
+#endif
+
+// Path of the DPU kernels. There is one binary for each number of tasklets
 #ifndef DPU_BINARY
-#define DPU_BINARY "./task"
+#define DPU_BINARY "./task_%u"
+#endif
+
+#ifndef DEFAULT_NR_TASKLETS
+#define DEFAULT_NR_TASKLETS 16
 #endif
 
+// Max number of edges sent to each DPU in a single transfer (30MB)
+#define MAX_EDGES_PER_TRANSFER ((30 * 1024 * 1024) / sizeof(edge_t))
+
 // For double comparisons
 #define EPSILON 0.000001
 
+// Returns a value in [0, 1) that depends only on the edge and on the seed (splitmix64 finalizer).
+// The edges kept by -p do not depend on which thread handles them, or in which order
+static inline double edge_sampling_value(edge_t edge, int32_t seed) {
+	uint64_t x = (((uint64_t)edge.u << 32) | edge.v) ^ ((uint64_t)(uint32_t)seed * 0x9E3779B97F4A7C15);
+	x          = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+	x          = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+	x          = x ^ (x >> 31);
+	return (x >> 11) * (1.0 / (UINT64_C(1) << 53));
+}
+
+// The DPUs may be allocated by another thread
 typedef struct {
-	uint32_t p;
-	uint32_t a;
-	uint32_t b;
-} hash_parameters_t;
+	struct dpu_set_t* dpu_set;
+	uint32_t          nr_dpus;
+	uint32_t          nr_tasklets; // Selects the DPU binary
+} dpu_allocation_args_t;
 
 // Print how the program should be executed (arguments)
 void usage();
 
 // Allocate the DPUs and load the kernel
-void* allocate_dpus(void* dpu_set);
+void* allocate_dpus(void* allocation_args);
+
+// Path of the DPU binary compiled for the given number of tasklets. dpu_binary must hold PATH_MAX chars
+void get_dpu_binary_path(char* dpu_binary, uint32_t nr_tasklets);
+
+// Send the input arguments and launch the setup of the DPUs, without waiting for it. The DPUs receive the triplets from
+// first_triplet on. Each estimator has triplets_per_estimator triplets, and the DPUs of the estimator i use seed + i
+void setup_dpus(struct dpu_set_t dpu_set, const dpu_arguments_t* input_arguments, uint32_t first_triplet,
+                uint32_t triplets_per_estimator);
+
+// Set the execution code of the next launch of the DPUs (see common.h), with the max node id used to count
+void set_execution_code(struct dpu_set_t dpu_set, uint32_t execution_code, uint32_t max_node_id);
+
+// Reset the state of the DPUs with the execution code 2, so that they forget their sample and can receive the triplets
+// of another round without loading the kernel again. The next launch does the setup
+void reset_dpus(struct dpu_set_t dpu_set);
+
+// Wait for the DPUs to count the triangles, and read the estimation of the first nr_triplets DPUs
+void read_triangle_estimations(struct dpu_set_t dpu_set, uint64_t* estimations, uint32_t nr_triplets);
 
 // Get time difference between two moments to calculate execution time
 float timedifference_msec(struct timeval t0, struct timeval t1);
@@ -39,10 +95,8 @@ float timedifference_msec(struct timeval t0, struct timeval t1);
 // Get the number of free bytes in memory
 uint64_t get_free_memory();
 
-// Get the parameters for the coloring hash function
-hash_parameters_t get_hash_parameters();
-
 // Find t most frequent nodes starting from the data from the threads
-uint32_t global_top_freq(node_frequency_t** top_freq_th, node_frequency_t* result_top_f, uint32_t t);
+uint32_t global_top_freq(node_frequency_t** top_freq_th, uint32_t nr_threads, node_frequency_t* result_top_f,
+                         uint32_t t);
 
 #endif //__HOST_H__
@@ -0,0 +1,228 @@
+#include <dpu.h>
+#include <math.h>    // Round the number of triplets
+#include <pthread.h> // Threads
+#include <stdatomic.h>
+#include <stdbool.h>  // Booleans
+#include <stdint.h>   // Fixed size integers
+#include <stdio.h>    // Print
+#include <stdlib.h>   // Various
+#include <string.h>   // Copy the magic string
+#include <sys/mman.h> // Allocate the triangles
+
+#include "../common/common.h"
+#include "degree_order.h"
+#include "ensemble.h"
+#include "local_counts.h"
+
+// Pairs of the DPUs handled by a merging thread, in a transfer
+typedef struct {
+	uint32_t        th_id;
+	local_counts_t* counts;
+
+	const node_triangles_t* pairs;    // LOCAL_COUNTS_TRANSFER_PAIRS for each DPU
+	const uint64_t*         nr_pairs; // Of each DPU, in the transfer
+	const double*           weights;  // Multiplier of the triplet of each DPU, times the scale of the DPU
+	uint32_t                nr_dpus;
+
+	// Top frequent nodes remapped by the DPUs
+	uint32_t                max_node_id;
+	const node_frequency_t* top_frequent_nodes;
+	uint32_t                nr_top_nodes;
+} merge_local_counts_args_t;
+
+void create_local_counts(local_counts_t* counts, uint32_t max_node_id, uint32_t nr_threads) {
+	counts->max_node_id = max_node_id;
+	counts->nr_threads  = nr_threads;
+	counts->degrees     = create_degrees(max_node_id);
+
+	// Anonymous pages are zeroed by the kernel, and all zero bytes are 0.0. MAP_NORESERVE allows reserving the full
+	// range of node ids
+	counts->triangles =
+	    (_Atomic double*)mmap(0, ((uint64_t)max_node_id + 1) * sizeof(double), PROT_READ | PROT_WRITE,
+	                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (counts->triangles == MAP_FAILED) {
+		printf("Cannot allocate the local counts of the nodes.\n");
+		exit(1);
+	}
+}
+
+void delete_local_counts(local_counts_t* counts) {
+	delete_degrees(counts->degrees, counts->max_node_id);
+	munmap((void*)counts->triangles, ((uint64_t)counts->max_node_id + 1) * sizeof(double));
+}
+
+// There is no atomic addition of doubles, the sum is replaced with compare-and-swap until no other thread changed it
+static inline void atomic_add_double(_Atomic double* sum, double value) {
+	double expected = atomic_load_explicit(sum, memory_order_relaxed);
+	while (!atomic_compare_exchange_weak_explicit(sum, &expected, expected + value, memory_order_relaxed,
+	                                              memory_order_relaxed)) {
+	}
+}
+
+// The threads handle different DPUs, and a node can be in the pairs of all of them
+static void* merge_local_counts(void* args_thread) {
+	merge_local_counts_args_t* args   = (merge_local_counts_args_t*)args_thread;
+	local_counts_t*            counts = args->counts;
+
+	for (uint32_t dpu_id = args->th_id; dpu_id < args->nr_dpus; dpu_id += counts->nr_threads) {
+		const node_triangles_t* pairs = &args->pairs[(uint64_t)dpu_id * LOCAL_COUNTS_TRANSFER_PAIRS];
+
+		for (uint64_t pair = 0; pair < args->nr_pairs[dpu_id]; pair++) {
+			uint32_t node_id = pairs[pair].node_id;
+
+			// The DPUs give the ids after max_node_id to the top frequent nodes, in reverse order
+			if (node_id > args->max_node_id) {
+				if (node_id - args->max_node_id > args->nr_top_nodes) {
+					continue;
+				}
+				node_id = args->top_frequent_nodes[args->max_node_id + args->nr_top_nodes - node_id].node_id;
+			}
+
+			if (node_id > counts->max_node_id) {
+				continue;
+			}
+
+			// Not rounded, the weights are fractional and the rounding of each pair would bias the sum
+			atomic_add_double(&counts->triangles[node_id], pairs[pair].triangles * args->weights[dpu_id]);
+		}
+	}
+
+	pthread_exit(NULL);
+}
+
+void read_local_counts(local_counts_t* counts, struct dpu_set_t dpu_set, uint32_t first_triplet, uint32_t nr_triplets,
+                       uint32_t colors, uint32_t max_node_id, const node_frequency_t* top_frequent_nodes,
+                       uint32_t nr_top_nodes) {
+	DPU_ASSERT(dpu_sync(dpu_set));
+
+	uint32_t nr_dpus;
+	DPU_ASSERT(dpu_get_nr_dpus(dpu_set, &nr_dpus));
+	uint64_t* dpu_pairs   = (uint64_t*)malloc(nr_dpus * sizeof(uint64_t));
+	double*   dpu_weights = (double*)malloc(nr_dpus * sizeof(double));
+
+	struct dpu_set_t dpu;
+	uint32_t         dpu_id;
+	DPU_FOREACH(dpu_set, dpu, dpu_id) {
+		DPU_ASSERT(dpu_prepare_xfer(dpu, &dpu_pairs[dpu_id]));
+	}
+	DPU_ASSERT(
+	    dpu_push_xfer(dpu_set, DPU_XFER_FROM_DPU, "nr_local_counts", 0, sizeof(dpu_pairs[0]), DPU_XFER_DEFAULT));
+
+	DPU_FOREACH(dpu_set, dpu, dpu_id) {
+		DPU_ASSERT(dpu_prepare_xfer(dpu, &dpu_weights[dpu_id]));
+	}
+	DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_FROM_DPU, "local_counts_scale", 0, sizeof(dpu_weights[0]),
+	                         DPU_XFER_DEFAULT));
+
+	// The DPUs beyond the triplets have no edges
+	uint32_t triplets_created = round((1.0 / 6) * colors * (colors + 1) * (colors + 2));
+	uint64_t max_pairs        = 0;
+	for (dpu_id = 0; dpu_id < nr_triplets; dpu_id++) {
+		dpu_weights[dpu_id] *= get_triplet_multiplier((first_triplet + dpu_id) % triplets_created, colors);
+		max_pairs = (dpu_pairs[dpu_id] > max_pairs) ? dpu_pairs[dpu_id] : max_pairs;
+	}
+
+	// The pairs are read a part at a time, so that the buffer does not depend on the size of the samples
+	node_triangles_t* pairs =
+	    (node_triangles_t*)malloc((uint64_t)nr_dpus * LOCAL_COUNTS_TRANSFER_PAIRS * sizeof(node_triangles_t));
+	uint64_t*                  transfer_pairs = (uint64_t*)malloc(nr_triplets * sizeof(uint64_t));
+	pthread_t*                 threads        = (pthread_t*)malloc(counts->nr_threads * sizeof(pthread_t));
+	merge_local_counts_args_t* merge_args =
+	    (merge_local_counts_args_t*)malloc(counts->nr_threads * sizeof(merge_local_counts_args_t));
+
+	for (uint64_t first_pair = 0; first_pair < max_pairs; first_pair += LOCAL_COUNTS_TRANSFER_PAIRS) {
+		uint64_t pairs_to_read = max_pairs - first_pair;
+		pairs_to_read = (pairs_to_read < LOCAL_COUNTS_TRANSFER_PAIRS) ? pairs_to_read : LOCAL_COUNTS_TRANSFER_PAIRS;
+
+		DPU_FOREACH(dpu_set, dpu, dpu_id) {
+			DPU_ASSERT(dpu_prepare_xfer(dpu, &pairs[(uint64_t)dpu_id * LOCAL_COUNTS_TRANSFER_PAIRS]));
+		}
+		DPU_ASSERT(dpu_push_xfer(dpu_set, DPU_XFER_FROM_DPU, DPU_MRAM_HEAP_POINTER_NAME,
+		                         first_pair * sizeof(node_triangles_t), pairs_to_read * sizeof(node_triangles_t),
+		                         DPU_XFER_DEFAULT));
+
+		// The DPUs with fewer pairs are only read up to their last pair
+		for (dpu_id = 0; dpu_id < nr_triplets; dpu_id++) {
+			transfer_pairs[dpu_id] = (dpu_pairs[dpu_id] > first_pair) ? dpu_pairs[dpu_id] - first_pair : 0;
+			transfer_pairs[dpu_id] = (transfer_pairs[dpu_id] < pairs_to_read) ? transfer_pairs[dpu_id] : pairs_to_read;
+		}
+
+		for (uint32_t th_id = 0; th_id < counts->nr_threads; th_id++) {
+			merge_args[th_id] = (merge_local_counts_args_t){
+			    .th_id              = th_id,
+			    .counts             = counts,
+			    .pairs              = pairs,
+			    .nr_pairs           = transfer_pairs,
+			    .weights            = dpu_weights,
+			    .nr_dpus            = nr_triplets,
+			    .max_node_id        = max_node_id,
+			    .top_frequent_nodes = top_frequent_nodes,
+			    .nr_top_nodes       = nr_top_nodes,
+			};
+			pthread_create(&threads[th_id], NULL, merge_local_counts, (void*)&merge_args[th_id]);
+		}
+		for (uint32_t th_id = 0; th_id < counts->nr_threads; th_id++) {
+			pthread_join(threads[th_id], NULL);
+		}
+	}
+
+	free(merge_args);
+	free(threads);
+	free(transfer_pairs);
+	free(pairs);
+	free(dpu_weights);
+	free(dpu_pairs);
+}
+
+uint64_t write_local_counts(const local_counts_t* counts, FILE* file, uint32_t max_node_id, double scale) {
+	max_node_id = (max_node_id < counts->max_node_id) ? max_node_id : counts->max_node_id;
+
+	local_counts_header_t header = {.version = LOCAL_COUNTS_VERSION, .padding = 0, .nr_nodes = 0};
+	memcpy(header.magic, LOCAL_COUNTS_MAGIC, sizeof(header.magic));
+	for (uint64_t node_id = 0; node_id <= max_node_id; node_id++) {
+		if (atomic_load_explicit(&counts->degrees[node_id], memory_order_relaxed) > 0) {
+			header.nr_nodes++;
+		}
+	}
+
+	bool is_written = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	// The records are written a block at a time
+	local_counts_record_t records[1024];
+	uint32_t              nr_records = 0;
+	for (uint64_t node_id = 0; node_id <= max_node_id && is_written; node_id++) {
+		uint32_t degree = atomic_load_explicit(&counts->degrees[node_id], memory_order_relaxed);
+		if (degree == 0) {
+			continue;
+		}
+
+		// The estimation can be negative or too high, the triangles of a node are between 0 and its pairs of neighbors
+		double pairs_of_neighbors = (double)degree * (degree - 1) / 2;
+		double triangles = atomic_load_explicit(&counts->triangles[node_id], memory_order_relaxed) * scale;
+		triangles        = (triangles < 0) ? 0 : (triangles > pairs_of_neighbors) ? pairs_of_neighbors : triangles;
+
+		records[nr_records++] = (local_counts_record_t){
+		    .node_id    = node_id,
+		    .degree     = degree,
+		    .triangles  = triangles,
+		    .clustering = (degree > 1) ? triangles / pairs_of_neighbors : 0,
+		};
+
+		if (nr_records == sizeof(records) / sizeof(records[0])) {
+			is_written = fwrite(records, sizeof(local_counts_record_t), nr_records, file) == nr_records;
+			nr_records = 0;
+		}
+	}
+
+	if (is_written && nr_records > 0) {
+		is_written = fwrite(records, sizeof(local_counts_record_t), nr_records, file) == nr_records;
+	}
+
+	is_written = is_written && fflush(file) == 0;
+	if (!is_written) {
+		printf("Cannot write the local counts.\n");
+		exit(1);
+	}
+
+	return header.nr_nodes;
+}
@@ -0,0 +1,60 @@
+#ifndef __LOCAL_COUNTS_H__
+#define __LOCAL_COUNTS_H__
+
+#include <dpu.h>
+#include <stdatomic.h>
+#include <stdint.h> // Fixed size integers
+#include <stdio.h>  // Write the file
+
+#include "../common/common.h"
+
+// File of the local counts: a header followed by header.nr_nodes records, one for each node with at least one edge,
+// ordered by id
+#define LOCAL_COUNTS_MAGIC   "PIMTCLCC"
+#define LOCAL_COUNTS_VERSION 1
+
+// Pairs read from each DPU in a transfer (64KB)
+#ifndef LOCAL_COUNTS_TRANSFER_PAIRS
+#define LOCAL_COUNTS_TRANSFER_PAIRS 8192
+#endif
+
+// 24 bytes, so that the records after the header are aligned to 8 bytes
+typedef struct {
+	char     magic[8];
+	uint32_t version;
+	uint32_t padding;
+	uint64_t nr_nodes;
+} local_counts_header_t;
+
+typedef struct {
+	uint32_t node_id;
+	uint32_t degree;     // In the graph, without the dropped duplicates and self-loops
+	double   triangles;  // Estimation, no more than the pairs of neighbors of the node
+	double   clustering; // Triangles over pairs of neighbors. 0 with less than two neighbors
+} local_counts_record_t;
+
+// Triangles of each node of the graph, from the pairs of node and triangles of the DPUs (see node_triangles_t). The
+// pairs are weighted like the triangles of their triplets in combine_triplet_estimations, so that the triangles with
+// all the nodes of the same color are counted once
+typedef struct {
+	uint32_t          max_node_id; // Of the arrays. Their pages are only allocated when touched, like the degrees
+	_Atomic uint32_t* degrees;     // Counted by the threads creating the batches
+	_Atomic double*   triangles;   // Sum of the estimators, rounded only when written
+	uint32_t          nr_threads;  // Merging the pairs of the DPUs
+} local_counts_t;
+
+void create_local_counts(local_counts_t* counts, uint32_t max_node_id, uint32_t nr_threads);
+
+void delete_local_counts(local_counts_t* counts);
+
+// Wait for the DPUs to count the triangles, and add the pairs of the first nr_triplets DPUs, which count the triplets
+// from first_triplet on. The DPUs counted with max_node_id, and their node ids above it are the top frequent nodes
+void read_local_counts(local_counts_t* counts, struct dpu_set_t dpu_set, uint32_t first_triplet, uint32_t nr_triplets,
+                       uint32_t colors, uint32_t max_node_id, const node_frequency_t* top_frequent_nodes,
+                       uint32_t nr_top_nodes);
+
+// Write the nodes up to max_node_id, with their triangles multiplied by scale. Returns the number of nodes written.
+// Exits if the file cannot be written
+uint64_t write_local_counts(const local_counts_t* counts, FILE* file, uint32_t max_node_id, double scale);
+
+#endif /* __LOCAL_COUNTS_H__ */
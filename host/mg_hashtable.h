@@ -30,13 +30,7 @@ bool is_prime(uint32_t value);
 // Returns the first prime value over the given value
 uint32_t first_prime_over(uint32_t value);
 
-// Apply Misra-Gries
-// If the node id is present, increment its frequency
-// If the node id is not present, if there is still enough space, add the node id
-// If the node id is not present and there is not enough space, decrement all frequencies
-void update_top_frequency(node_freq_hashtable_t* table, uint32_t node_id);
-
-// Take t most frequent nodes from the threads
+// Sum the frequencies of the top frequent nodes from the threads
 void update_global_top_frequency(node_freq_hashtable_t* table, uint32_t node_id, uint32_t node_frequency);
 
 #endif //__MG_HASHTABLE_H__
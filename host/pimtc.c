@@ -0,0 +1,74 @@
+#include <limits.h> // Max path length
+#include <stdio.h>  // Print the errors
+#include <stdlib.h> // Various
+#include <unistd.h> // Check the DPU binary
+
+#include "count_job.h"
+#include "host_util.h"
+#include "pimtc.h"
+
+struct pimtc_context {
+	dpu_context_t dpus;
+};
+
+pimtc_context_t* pimtc_create(uint32_t nr_dpus, uint32_t nr_tasklets, char* error) {
+	char dpu_binary[PATH_MAX];
+	get_dpu_binary_path(dpu_binary, nr_tasklets);
+	if (access(dpu_binary, F_OK) != 0) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "No DPU binary for %u tasklets (%.200s).", nr_tasklets, dpu_binary);
+		return NULL;
+	}
+
+	if (nr_dpus == 0) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "Invalid number of DPUs.");
+		return NULL;
+	}
+
+	// The first count waits for the allocation only before launching the DPUs
+	pimtc_context_t* context = (pimtc_context_t*)malloc(sizeof(pimtc_context_t));
+	create_dpu_context(&context->dpus, nr_dpus, nr_tasklets, true);
+
+	return context;
+}
+
+void pimtc_init_job(count_job_t* job) {
+	init_count_job(job);
+	job->is_quiet = true;
+}
+
+// The job is checked on the DPUs of the context, then run
+static bool count_job(pimtc_context_t* context, count_job_t* job, count_result_t* result, char* error) {
+	if (!check_count_job(job, context->dpus.nr_dpus, error)) {
+		return false;
+	}
+	return run_count_job(job, &context->dpus, result, error);
+}
+
+bool pimtc_count_file(pimtc_context_t* context, count_job_t* job, const char* filename, count_result_t* result,
+                      char* error) {
+	job->filename = (char*)filename; // Only read
+	job->edges    = NULL;
+	job->nr_edges = 0;
+	return count_job(context, job, result, error);
+}
+
+bool pimtc_count_edges(pimtc_context_t* context, count_job_t* job, const edge_t* edges, uint64_t nr_edges,
+                       count_result_t* result, char* error) {
+	if (nr_edges == 0) {
+		snprintf(error, COUNT_JOB_ERROR_SIZE, "The graph has no edges.");
+		return false;
+	}
+
+	job->edges    = edges;
+	job->nr_edges = nr_edges;
+	return count_job(context, job, result, error);
+}
+
+void pimtc_delete_result(count_result_t* result) {
+	delete_count_result(result);
+}
+
+void pimtc_destroy(pimtc_context_t* context) {
+	delete_dpu_context(&context->dpus);
+	free(context);
+}
@@ -0,0 +1,43 @@
+#ifndef __PIMTC_H__
+#define __PIMTC_H__
+
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+
+#include "../common/common.h"
+#include "count_job.h"
+
+// Library interface of the triangle counting, built as libpimtc.a. A context keeps the DPUs allocated and loaded across
+// the counts, so that only the first count pays for the allocation. The counts of a context must not run concurrently,
+// but different contexts can count in different threads. The parameters of a count are a count_job_t, whose fields are
+// the options of the command line. The incremental jobs (is_incremental) extend the samples of the previous incremental
+// count of the context. The counts of a sliding window (window_size) are in the windows of the result.
+// A graph file that cannot be read is returned as an error, but the other errors of the system (allocations, the
+// DPUs) still stop the process, like in app
+
+// DPUs of the counts. Opaque
+typedef struct pimtc_context pimtc_context_t;
+
+// Allocate nr_dpus DPUs in the background and load the kernel compiled for nr_tasklets tasklets, found at DPU_BINARY
+// (relative to the working directory unless DPU_BINARY is defined when building). Returns NULL and writes the error
+// (COUNT_JOB_ERROR_SIZE chars) if there is no such kernel
+pimtc_context_t* pimtc_create(uint32_t nr_dpus, uint32_t nr_tasklets, char* error);
+
+// Default parameters, without progress messages. The number of colors must be set
+void pimtc_init_job(count_job_t* job);
+
+// Count the triangles of a graph file (COO, binary or FIFO). Returns false and writes the error if the job is not
+// valid. The result must be deleted with pimtc_delete_result
+bool pimtc_count_file(pimtc_context_t* context, count_job_t* job, const char* filename, count_result_t* result,
+                      char* error);
+
+// Count the triangles of nr_edges edges in memory. The edges are only read
+bool pimtc_count_edges(pimtc_context_t* context, count_job_t* job, const edge_t* edges, uint64_t nr_edges,
+                       count_result_t* result, char* error);
+
+void pimtc_delete_result(count_result_t* result);
+
+// Free the DPUs
+void pimtc_destroy(pimtc_context_t* context);
+
+#endif /* __PIMTC_H__ */
@@ -0,0 +1,173 @@
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+#include <stdlib.h>  // Various
+
+#include "../common/common.h"
+#include "coo_parser.h"
+#include "routing.h"
+
+hash_parameters_t get_hash_parameters(int32_t seed, uint32_t candidate) {
+	// Expand the seed and the candidate with splitmix64, so that close seeds give unrelated colorings
+	uint64_t state = ((uint64_t)(uint32_t)seed << 32) | candidate;
+	uint64_t x[2];
+	for (uint32_t i = 0; i < 2; i++) {
+		state += 0x9E3779B97F4A7C15;
+		x[i] = state;
+		x[i] = (x[i] ^ (x[i] >> 30)) * 0xBF58476D1CE4E5B9;
+		x[i] = (x[i] ^ (x[i] >> 27)) * 0x94D049BB133111EB;
+		x[i] = x[i] ^ (x[i] >> 31);
+	}
+
+	return (hash_parameters_t){x[0] | 1, x[1]}; // a must be odd
+}
+
+// Add the DPU to the list of the edges colored (color_u, color_v), in both orders
+static void add_dpu_to_pair(routing_table_t* routing, uint32_t* nr_dpu_ids, uint32_t color_u, uint32_t color_v,
+                            uint32_t dpu_id) {
+	uint32_t pair_uv = color_u * routing->colors + color_v;
+	uint32_t pair_vu = color_v * routing->colors + color_u;
+
+	routing->dpu_ids[pair_uv * routing->colors + nr_dpu_ids[pair_uv]++] = dpu_id;
+	if (pair_vu != pair_uv) {
+		routing->dpu_ids[pair_vu * routing->colors + nr_dpu_ids[pair_vu]++] = dpu_id;
+	}
+}
+
+void create_routing_table(routing_table_t* routing, uint32_t colors, hash_parameters_t hash) {
+	routing->colors = colors;
+	routing->hash   = hash;
+
+	routing->dpu_ids     = (uint16_t*)malloc(colors * colors * colors * sizeof(uint16_t));
+	uint32_t* nr_dpu_ids = (uint32_t*)calloc(colors * colors, sizeof(uint32_t));
+
+	// Each triplet handles the edges whose colors are one of its pairs. The same pair is added only once, so that the
+	// edges are not sent twice to the DPUs of the triplets (x, x, y), (x, y, y) and (x, x, x)
+	uint32_t dpu_id = 0;
+	for (uint32_t c1 = 0; c1 < colors; c1++) {
+		for (uint32_t c2 = c1; c2 < colors; c2++) {
+			for (uint32_t c3 = c2; c3 < colors; c3++) {
+				add_dpu_to_pair(routing, nr_dpu_ids, c1, c2, dpu_id);
+				if (c3 != c2) {
+					add_dpu_to_pair(routing, nr_dpu_ids, c1, c3, dpu_id);
+				}
+				if (c2 != c1) {
+					add_dpu_to_pair(routing, nr_dpu_ids, c2, c3, dpu_id);
+				}
+				dpu_id++;
+			}
+		}
+	}
+	routing->nr_triplets = dpu_id;
+
+	free(nr_dpu_ids);
+}
+
+void delete_routing_table(routing_table_t* routing) {
+	free(routing->dpu_ids);
+}
+
+void route_edges(const routing_table_t* routing, const edge_t* edges, uint32_t nr_edges, uint32_t* dpu_ids_offsets) {
+	uint32_t colors_u[ROUTING_BLOCK_EDGES];
+	uint32_t colors_v[ROUTING_BLOCK_EDGES];
+
+	for (uint32_t i = 0; i < nr_edges; i++) {
+		colors_u[i] = get_node_color(routing, edges[i].u);
+		colors_v[i] = get_node_color(routing, edges[i].v);
+	}
+
+	for (uint32_t i = 0; i < nr_edges; i++) {
+		dpu_ids_offsets[i] = get_dpu_ids_offset(routing, colors_u[i], colors_v[i]);
+	}
+}
+
+void count_triplet_edges(const routing_table_t* routing, const edge_t* edges, uint64_t nr_edges,
+                         uint64_t* triplet_edges, uint32_t nr_triplets) {
+	uint32_t  colors      = routing->colors;
+	uint64_t* pair_counts = (uint64_t*)calloc(colors * colors, sizeof(uint64_t));
+
+	// Only the pairs of colors are counted, each pair is then added to its colors triplets
+	for (uint64_t i = 0; i < nr_edges; i++) {
+		uint32_t color_u = get_node_color(routing, edges[i].u);
+		uint32_t color_v = get_node_color(routing, edges[i].v);
+		pair_counts[color_u * colors + color_v]++;
+	}
+
+	for (uint32_t triplet_id = 0; triplet_id < nr_triplets; triplet_id++) {
+		triplet_edges[triplet_id] = 0;
+	}
+	for (uint32_t pair = 0; pair < colors * colors; pair++) {
+		for (uint32_t i = 0; i < colors; i++) {
+			triplet_edges[routing->dpu_ids[pair * colors + i]] += pair_counts[pair];
+		}
+	}
+
+	free(pair_counts);
+}
+
+double get_load_ratio(const uint64_t* triplet_edges, uint32_t nr_triplets) {
+	uint64_t max_edges   = 0;
+	uint64_t total_edges = 0;
+	for (uint32_t triplet_id = 0; triplet_id < nr_triplets; triplet_id++) {
+		max_edges = (triplet_edges[triplet_id] > max_edges) ? triplet_edges[triplet_id] : max_edges;
+		total_edges += triplet_edges[triplet_id];
+	}
+
+	if (total_edges == 0) {
+		return 1.0;
+	}
+	return (double)max_edges * nr_triplets / total_edges;
+}
+
+uint64_t read_coloring_sample(const char* mmaped_file, uint64_t file_size, const edge_t* binary_edges,
+                              uint64_t nr_binary_edges, const uint32_t* node_ranks, edge_t* sample) {
+
+	uint64_t nr_sample_edges = 0;
+	if (binary_edges != NULL) {
+		nr_sample_edges = (nr_binary_edges < COLORING_SAMPLE_EDGES) ? nr_binary_edges : COLORING_SAMPLE_EDGES;
+		for (uint64_t i = 0; i < nr_sample_edges; i++) {
+			sample[i] = binary_edges[i];
+		}
+	} else {
+		uint64_t pos = 0;
+		while (pos < file_size && nr_sample_edges < COLORING_SAMPLE_EDGES) {
+			bool is_valid_edge;
+			pos = parse_coo_line(mmaped_file, pos, file_size, &sample[nr_sample_edges], &is_valid_edge);
+			if (is_valid_edge) {
+				nr_sample_edges++;
+			}
+		}
+	}
+
+	if (node_ranks != NULL) {
+		for (uint64_t i = 0; i < nr_sample_edges; i++) {
+			sample[i] = (edge_t){node_ranks[sample[i].u], node_ranks[sample[i].v]};
+		}
+	}
+
+	return nr_sample_edges;
+}
+
+uint32_t choose_coloring(int32_t seed, uint32_t nr_candidates, uint32_t colors, const edge_t* sample,
+                         uint64_t nr_sample_edges, uint32_t nr_triplets, double* load_ratio) {
+
+	uint64_t* triplet_edges  = (uint64_t*)malloc(nr_triplets * sizeof(uint64_t));
+	uint32_t  best_candidate = 0;
+	*load_ratio              = 0;
+
+	for (uint32_t candidate = 0; candidate < nr_candidates; candidate++) {
+		routing_table_t routing;
+		create_routing_table(&routing, colors, get_hash_parameters(seed, candidate));
+		count_triplet_edges(&routing, sample, nr_sample_edges, triplet_edges, nr_triplets);
+		delete_routing_table(&routing);
+
+		double candidate_load_ratio = get_load_ratio(triplet_edges, nr_triplets);
+		if (candidate == 0 || candidate_load_ratio < *load_ratio) {
+			best_candidate = candidate;
+			*load_ratio    = candidate_load_ratio;
+		}
+	}
+
+	free(triplet_edges);
+
+	return best_candidate;
+}
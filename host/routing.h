@@ -0,0 +1,79 @@
+#ifndef __ROUTING_H__
+#define __ROUTING_H__
+
+#include <stdint.h> // Fixed size integers
+
+#include "../common/common.h"
+
+// The DPU ids are stored in 16 bits
+#define MAX_ROUTING_TRIPLETS UINT16_MAX
+
+// Number of edges colored and routed at once by each thread
+#ifndef ROUTING_BLOCK_EDGES
+#define ROUTING_BLOCK_EDGES 256
+#endif
+
+// Number of edges at the start of the graph used to compare the candidate colorings
+#ifndef COLORING_SAMPLE_EDGES
+#define COLORING_SAMPLE_EDGES (1024 * 1024)
+#endif
+
+// Multiply-add-shift hash in 64-bit arithmetic. The color of a node is the high half of (a * id + b), scaled to the
+// number of colors
+typedef struct {
+	uint64_t a; // Odd
+	uint64_t b;
+} hash_parameters_t;
+
+// Precomputed routing of the edges to the DPUs. Each edge is sent to the colors DPUs whose triplet contains the colors
+// of its nodes. The triplets (c1, c2, c3), with c1 <= c2 <= c3, are assigned to the DPUs in lexicographic order
+typedef struct {
+	uint32_t          colors;
+	uint32_t          nr_triplets; // binom(colors + 2, 3), one DPU for each
+	hash_parameters_t hash;
+
+	uint16_t* dpu_ids; // colors DPU ids for each ordered pair of colors (color_u, color_v), in increasing order
+} routing_table_t;
+
+// Get the parameters for the coloring hash function. Each candidate gives a different coloring for the same seed
+hash_parameters_t get_hash_parameters(int32_t seed, uint32_t candidate);
+
+// Build the routing table for the given colors and coloring hash function
+void create_routing_table(routing_table_t* routing, uint32_t colors, hash_parameters_t hash);
+
+void delete_routing_table(routing_table_t* routing);
+
+// Color hashing formula: (((a * id + b) >> 32) * colors) >> 32. No divisions, so blocks of nodes can be vectorized.
+// The deletion flag is ignored, so that the deletions are routed like the edges they delete
+static inline uint32_t get_node_color(const routing_table_t* routing, uint32_t node_id) {
+	uint64_t hash = (routing->hash.a * (node_id & ~EDGE_DELETION_FLAG) + routing->hash.b) >> 32;
+	return (hash * routing->colors) >> 32;
+}
+
+// Offset in dpu_ids of the DPU ids handling an edge with the given colors. The colors do not need to be ordered
+static inline uint32_t get_dpu_ids_offset(const routing_table_t* routing, uint32_t color_u, uint32_t color_v) {
+	return (color_u * routing->colors + color_v) * routing->colors;
+}
+
+// Write the offset of the DPU ids of each edge of the block. The nodes are colored first, without branches, and only
+// then the offsets are computed
+void route_edges(const routing_table_t* routing, const edge_t* edges, uint32_t nr_edges, uint32_t* dpu_ids_offsets);
+
+// Count the edges received by each triplet if the given edges are routed with the table
+void count_triplet_edges(const routing_table_t* routing, const edge_t* edges, uint64_t nr_edges,
+                         uint64_t* triplet_edges, uint32_t nr_triplets);
+
+// Max over mean of the edges received by the triplets. The busiest DPU sets the time needed to count the triangles
+double get_load_ratio(const uint64_t* triplet_edges, uint32_t nr_triplets);
+
+// Copy at most COLORING_SAMPLE_EDGES edges from the start of a mmapped graph. binary_edges is NULL if the graph is in
+// COO format. The nodes are relabeled with node_ranks, if not NULL. Returns the number of edges copied
+uint64_t read_coloring_sample(const char* mmaped_file, uint64_t file_size, const edge_t* binary_edges,
+                              uint64_t nr_binary_edges, const uint32_t* node_ranks, edge_t* sample);
+
+// Route the sample with nr_candidates colorings derived from the seed. Returns the candidate with the lowest load
+// ratio, which is written in load_ratio
+uint32_t choose_coloring(int32_t seed, uint32_t nr_candidates, uint32_t colors, const edge_t* sample,
+                         uint64_t nr_sample_edges, uint32_t nr_triplets, double* load_ratio);
+
+#endif /* __ROUTING_H__ */
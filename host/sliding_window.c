@@ -0,0 +1,93 @@
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+#include <stdio.h>   // Print
+#include <stdlib.h>  // Various
+#include <string.h>  // Move the edges when the buffer grows
+
+#include "../common/common.h"
+#include "sliding_window.h"
+
+void create_sliding_window(sliding_window_t* window, uint64_t size, uint64_t period, bool is_timed) {
+	*window = (sliding_window_t){
+	    .size          = size,
+	    .period        = period,
+	    .is_timed      = is_timed,
+	    .capacity      = WINDOW_INITIAL_EDGES,
+	    .first         = 0,
+	    .nr_edges      = 0,
+	    .nr_inserted   = 0,
+	    .period_end    = is_timed ? 0 : period, // The period of a time window starts with its first edge
+	    .counted_end   = 0,
+	    .has_chunk     = false,
+	    .is_input_over = false,
+	};
+
+	// A window of edges never holds more than size edges
+	if (!is_timed && size < window->capacity) {
+		window->capacity = size;
+	}
+
+	window->edges      = (edge_t*)malloc(window->capacity * sizeof(edge_t));
+	window->timestamps = is_timed ? (uint64_t*)malloc(window->capacity * sizeof(uint64_t)) : NULL;
+	if (window->edges == NULL || (is_timed && window->timestamps == NULL)) {
+		printf("Cannot allocate the memory for the edges of the window.\n");
+		exit(1);
+	}
+}
+
+void delete_sliding_window(sliding_window_t* window) {
+	free(window->edges);
+	free(window->timestamps);
+}
+
+// Double the capacity of the ring buffer. The edges after the end of the old buffer are moved to the new space
+static void grow_sliding_window(sliding_window_t* window) {
+	uint64_t old_capacity = window->capacity;
+	window->capacity *= 2;
+
+	window->edges = (edge_t*)realloc(window->edges, window->capacity * sizeof(edge_t));
+	if (window->is_timed) {
+		window->timestamps = (uint64_t*)realloc(window->timestamps, window->capacity * sizeof(uint64_t));
+	}
+	if (window->edges == NULL || (window->is_timed && window->timestamps == NULL)) {
+		printf("Cannot allocate the memory for the edges of the window.\n");
+		exit(1);
+	}
+
+	// The buffer is full, the edges before first wrapped around
+	memcpy(&window->edges[old_capacity], window->edges, window->first * sizeof(edge_t));
+	if (window->is_timed) {
+		memcpy(&window->timestamps[old_capacity], window->timestamps, window->first * sizeof(uint64_t));
+	}
+}
+
+void push_window_edge(sliding_window_t* window, edge_t edge, uint64_t timestamp) {
+	if (window->nr_edges == window->capacity) {
+		grow_sliding_window(window);
+	}
+
+	uint64_t last = (window->first + window->nr_edges) % window->capacity;
+	window->edges[last] = edge;
+	if (window->is_timed) {
+		window->timestamps[last] = timestamp;
+	}
+	window->nr_edges++;
+	window->nr_inserted++;
+}
+
+bool pop_expired_window_edge(sliding_window_t* window, uint64_t timestamp, edge_t* edge) {
+	if (window->nr_edges == 0) {
+		return false;
+	}
+
+	bool is_expired = window->is_timed ? window->timestamps[window->first] + window->size <= timestamp
+	                                   : window->nr_edges >= window->size;
+	if (!is_expired) {
+		return false;
+	}
+
+	*edge         = window->edges[window->first];
+	window->first = (window->first + 1 == window->capacity) ? 0 : window->first + 1;
+	window->nr_edges--;
+	return true;
+}
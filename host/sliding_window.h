@@ -0,0 +1,56 @@
+#ifndef __SLIDING_WINDOW_H__
+#define __SLIDING_WINDOW_H__
+
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+
+#include "../common/common.h"
+#include "chunk_scheduler.h"
+#include "stream_reader.h"
+
+// Initial number of edges of the window buffer. It doubles when it is full
+#ifndef WINDOW_INITIAL_EDGES
+#define WINDOW_INITIAL_EDGES (1024 * 1024)
+#endif
+
+// Last edges of a stream, read by a single thread. The edges leaving the window are sent to the DPUs as deletions, so
+// that their samples only hold edges of the window. The graph is read one period at a time: the thread stops at the
+// end of each period, so that the window can be counted, and the next thread resumes from the same position
+typedef struct {
+	uint64_t size;     // Edges, or time units of the timestamps
+	uint64_t period;   // Between two counts of the window, in the same unit
+	bool     is_timed; // The edges have a timestamp, in the third column of the COO lines
+
+	// Edges in the window, oldest first, in a ring buffer. The timestamps are only kept by the time windows
+	edge_t*   edges;
+	uint64_t* timestamps;
+	uint64_t  capacity;
+	uint64_t  first;
+	uint64_t  nr_edges;
+
+	uint64_t nr_inserted;    // Edges inserted since the start of the stream
+	uint64_t last_timestamp; // The timestamps lower than the last one are replaced by it
+	uint64_t period_end;     // Edges inserted or timestamp ending the current period
+	uint64_t counted_end;    // End of the last period that is over, when the thread stops
+
+	// Position of the thread in the input. A chunk is kept when a period ends in the middle of it
+	input_chunk_t   chunk;
+	stream_chunk_t* stream_chunk;
+	bool            has_chunk;
+	uint64_t        position;
+	bool            is_input_over;
+} sliding_window_t;
+
+// Window of the last size edges, or of the edges of the last size time units if is_timed
+void create_sliding_window(sliding_window_t* window, uint64_t size, uint64_t period, bool is_timed);
+
+void delete_sliding_window(sliding_window_t* window);
+
+// Add the newest edge. Its timestamp is ignored by the windows of edges
+void push_window_edge(sliding_window_t* window, edge_t edge, uint64_t timestamp);
+
+// Remove the oldest edge if it leaves the window when a new edge with the timestamp is added: a window of edges keeps
+// size - 1 older edges, a time window the edges more recent than timestamp - size. Returns false if no edge leaves
+bool pop_expired_window_edge(sliding_window_t* window, uint64_t timestamp, edge_t* edge);
+
+#endif /* __SLIDING_WINDOW_H__ */
@@ -0,0 +1,220 @@
+#include <stdint.h> // Fixed size integers
+#include <stdlib.h> // Various
+
+#include "../common/common.h"
+#include "space_saving.h"
+
+space_saving_t create_space_saving(uint32_t k) {
+
+	// The index is a power of two at least twice as big as k, so that the probing distance stays short
+	uint32_t index_bits = 1;
+	while ((UINT64_C(1) << index_bits) < 2 * (uint64_t)k) {
+		index_bits++;
+	}
+	uint32_t index_size = 1u << index_bits;
+
+	space_saving_t summary = {
+	    .k               = k,
+	    .nr_counters     = 0,
+	    .counters        = (ss_counter_t*)malloc(k * sizeof(ss_counter_t)),
+	    .buckets         = (ss_bucket_t*)malloc(k * sizeof(ss_bucket_t)),
+	    .free_buckets    = (uint32_t*)malloc(k * sizeof(uint32_t)),
+	    .nr_free_buckets = k,
+	    .min_bucket      = SPACE_SAVING_NONE,
+	    .max_bucket      = SPACE_SAVING_NONE,
+	    .index           = (uint32_t*)malloc(index_size * sizeof(uint32_t)),
+	    .index_mask      = index_size - 1,
+	    .index_shift     = 32 - index_bits,
+	};
+
+	for (uint32_t i = 0; i < k; i++) {
+		summary.free_buckets[i] = k - 1 - i;
+	}
+	for (uint32_t i = 0; i < index_size; i++) {
+		summary.index[i] = SPACE_SAVING_NONE;
+	}
+
+	return summary;
+}
+
+void delete_space_saving(space_saving_t* summary) {
+	free(summary->counters);
+	free(summary->buckets);
+	free(summary->free_buckets);
+	free(summary->index);
+}
+
+// Fibonacci hashing: the high bits of the product depend on all the bits of the node id
+static inline uint32_t home_slot(const space_saving_t* summary, uint32_t node_id) {
+	return (node_id * 2654435769u) >> summary->index_shift;
+}
+
+// Returns the slot of the index with the node, or the empty slot where it would be inserted
+static inline uint32_t find_slot(const space_saving_t* summary, uint32_t node_id) {
+	uint32_t slot = home_slot(summary, node_id);
+	while (summary->index[slot] != SPACE_SAVING_NONE && summary->counters[summary->index[slot]].node_id != node_id) {
+		slot = (slot + 1) & summary->index_mask;
+	}
+	return slot;
+}
+
+// Backward shift deletion: the following nodes are moved into the hole, so no tombstones are needed even if nodes are
+// replaced all the time
+static void remove_from_index(space_saving_t* summary, uint32_t slot) {
+	uint32_t hole = slot;
+	uint32_t next = (slot + 1) & summary->index_mask;
+
+	while (summary->index[next] != SPACE_SAVING_NONE) {
+		uint32_t home = home_slot(summary, summary->counters[summary->index[next]].node_id);
+
+		// The node can be moved only if the hole is between its home slot and its current slot
+		if (((next - home) & summary->index_mask) >= ((next - hole) & summary->index_mask)) {
+			summary->index[hole] = summary->index[next];
+			hole                 = next;
+		}
+		next = (next + 1) & summary->index_mask;
+	}
+
+	summary->index[hole] = SPACE_SAVING_NONE;
+}
+
+// Insert an empty bucket between prev and next
+static uint32_t create_bucket(space_saving_t* summary, uint32_t frequency, uint32_t prev, uint32_t next) {
+	uint32_t bucket          = summary->free_buckets[--summary->nr_free_buckets];
+	summary->buckets[bucket] = (ss_bucket_t){frequency, SPACE_SAVING_NONE, prev, next};
+
+	if (prev != SPACE_SAVING_NONE) {
+		summary->buckets[prev].next = bucket;
+	} else {
+		summary->min_bucket = bucket;
+	}
+	if (next != SPACE_SAVING_NONE) {
+		summary->buckets[next].prev = bucket;
+	} else {
+		summary->max_bucket = bucket;
+	}
+
+	return bucket;
+}
+
+static void delete_bucket(space_saving_t* summary, uint32_t bucket) {
+	uint32_t prev = summary->buckets[bucket].prev;
+	uint32_t next = summary->buckets[bucket].next;
+
+	if (prev != SPACE_SAVING_NONE) {
+		summary->buckets[prev].next = next;
+	} else {
+		summary->min_bucket = next;
+	}
+	if (next != SPACE_SAVING_NONE) {
+		summary->buckets[next].prev = prev;
+	} else {
+		summary->max_bucket = prev;
+	}
+
+	summary->free_buckets[summary->nr_free_buckets++] = bucket;
+}
+
+static inline void attach_counter(space_saving_t* summary, uint32_t counter, uint32_t bucket) {
+	uint32_t first = summary->buckets[bucket].first_counter;
+
+	summary->counters[counter].bucket = bucket;
+	summary->counters[counter].prev   = SPACE_SAVING_NONE;
+	summary->counters[counter].next   = first;
+	if (first != SPACE_SAVING_NONE) {
+		summary->counters[first].prev = counter;
+	}
+	summary->buckets[bucket].first_counter = counter;
+}
+
+static inline void detach_counter(space_saving_t* summary, uint32_t counter) {
+	ss_counter_t* current = &summary->counters[counter];
+
+	if (current->prev != SPACE_SAVING_NONE) {
+		summary->counters[current->prev].next = current->next;
+	} else {
+		summary->buckets[current->bucket].first_counter = current->next;
+	}
+	if (current->next != SPACE_SAVING_NONE) {
+		summary->counters[current->next].prev = current->prev;
+	}
+}
+
+// Move the counter to the bucket with the next frequency, creating it if needed
+static void increment_counter(space_saving_t* summary, uint32_t counter) {
+	uint32_t     bucket_id = summary->counters[counter].bucket;
+	ss_bucket_t* bucket    = &summary->buckets[bucket_id];
+	uint32_t     next_id   = bucket->next;
+
+	if (next_id != SPACE_SAVING_NONE && summary->buckets[next_id].frequency == bucket->frequency + 1) {
+		detach_counter(summary, counter);
+		if (bucket->first_counter == SPACE_SAVING_NONE) {
+			delete_bucket(summary, bucket_id);
+		}
+		attach_counter(summary, counter, next_id);
+	} else if (bucket->first_counter == counter && summary->counters[counter].next == SPACE_SAVING_NONE) {
+		bucket->frequency++; // Only counter in the bucket, the order of the buckets does not change
+	} else {
+		detach_counter(summary, counter);
+		attach_counter(summary, counter, create_bucket(summary, bucket->frequency + 1, bucket_id, next_id));
+	}
+}
+
+void update_space_saving(space_saving_t* summary, uint32_t node_id) {
+
+	uint32_t slot = find_slot(summary, node_id);
+	if (summary->index[slot] != SPACE_SAVING_NONE) {
+		increment_counter(summary, summary->index[slot]);
+		return;
+	}
+
+	// Not monitored, but there is still a free counter
+	if (summary->nr_counters < summary->k) {
+		uint32_t counter                   = summary->nr_counters++;
+		summary->counters[counter].node_id = node_id;
+		summary->index[slot]               = counter;
+
+		uint32_t bucket = summary->min_bucket;
+		if (bucket == SPACE_SAVING_NONE || summary->buckets[bucket].frequency != 1) {
+			bucket = create_bucket(summary, 1, SPACE_SAVING_NONE, summary->min_bucket);
+		}
+		attach_counter(summary, counter, bucket);
+		return;
+	}
+
+	// Replace a node with the minimum frequency. The new node inherits its frequency, plus one
+	uint32_t counter = summary->buckets[summary->min_bucket].first_counter;
+	remove_from_index(summary, find_slot(summary, summary->counters[counter].node_id));
+
+	summary->counters[counter].node_id = node_id;
+
+	// The deletion may have moved the empty slot of the new node
+	summary->index[find_slot(summary, node_id)] = counter;
+
+	increment_counter(summary, counter);
+}
+
+uint32_t get_top_frequent_nodes(const space_saving_t* summary, node_frequency_t* result, uint32_t n) {
+
+	uint32_t nr_nodes = 0;
+	uint32_t bucket   = summary->max_bucket;
+	while (bucket != SPACE_SAVING_NONE && nr_nodes < n) {
+
+		uint32_t counter = summary->buckets[bucket].first_counter;
+		while (counter != SPACE_SAVING_NONE && nr_nodes < n) {
+			result[nr_nodes].node_id   = summary->counters[counter].node_id;
+			result[nr_nodes].frequency = summary->buckets[bucket].frequency;
+			nr_nodes++;
+
+			counter = summary->counters[counter].next;
+		}
+
+		bucket = summary->buckets[bucket].prev;
+	}
+
+	for (uint32_t i = nr_nodes; i < n; i++) {
+		result[i] = (node_frequency_t){0, 0};
+	}
+
+	return nr_nodes;
+}
@@ -0,0 +1,61 @@
+#ifndef __SPACE_SAVING_H__
+#define __SPACE_SAVING_H__
+
+#include <stdint.h> // Fixed size integers
+
+#include "../common/common.h"
+
+// Marks the end of the lists and the empty cells of the index
+#define SPACE_SAVING_NONE UINT32_MAX
+
+// Monitored node. The counters with the same frequency are kept in a doubly linked list
+typedef struct {
+	uint32_t node_id;
+	uint32_t bucket; // Bucket with the frequency of the node
+	uint32_t prev;
+	uint32_t next;
+} ss_counter_t;
+
+// All the counters with the same frequency. The buckets are kept in a doubly linked list ordered by frequency
+typedef struct {
+	uint32_t frequency;
+	uint32_t first_counter;
+	uint32_t prev; // Lower frequency
+	uint32_t next; // Higher frequency
+} ss_bucket_t;
+
+// Space-Saving with the stream summary: each update takes constant time, also when the node replaces the least
+// frequent one. The frequencies are overestimated by at most the minimum frequency, and every node seen more than
+// edges / k times is monitored. Used by a single thread, so no locks are needed
+typedef struct {
+	uint32_t      k;
+	uint32_t      nr_counters; // Counters in use. No more than k
+	ss_counter_t* counters;
+
+	// There are never more buckets than counters, the free ones are kept in a stack
+	ss_bucket_t* buckets;
+	uint32_t*    free_buckets;
+	uint32_t     nr_free_buckets;
+	uint32_t     min_bucket;
+	uint32_t     max_bucket;
+
+	// Index from node id to counter. Open addressing with linear probing, at most half full
+	uint32_t* index;
+	uint32_t  index_mask;
+	uint32_t  index_shift;
+} space_saving_t;
+
+// Returns an empty summary that monitors at most k nodes
+space_saving_t create_space_saving(uint32_t k);
+
+void delete_space_saving(space_saving_t* summary);
+
+// Count one more occurrence of the node. If the node is not monitored and all the counters are used, it replaces the
+// node with the minimum frequency
+void update_space_saving(space_saving_t* summary, uint32_t node_id);
+
+// Write the n most frequent nodes, in order of decreasing frequency. The unused cells have frequency 0.
+// Returns the number of valid cells
+uint32_t get_top_frequent_nodes(const space_saving_t* summary, node_frequency_t* result, uint32_t n);
+
+#endif /* __SPACE_SAVING_H__ */
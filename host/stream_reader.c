@@ -0,0 +1,152 @@
+#define _GNU_SOURCE  // memrchr
+#include <errno.h>   // Interrupted reads
+#include <pthread.h> // Mutexes and condition variables
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+#include <stdio.h>   // Print
+#include <stdlib.h>  // Various
+#include <string.h>  // Copy the incomplete lines
+#include <unistd.h>  // Read
+
+#include "binary_graph.h"
+#include "stream_reader.h"
+
+void create_stream_reader(stream_reader_t* reader, int fd, uint32_t nr_chunks, uint64_t chunk_size) {
+	reader->fd         = fd;
+	reader->chunk_size = chunk_size;
+	reader->nr_chunks  = nr_chunks;
+
+	reader->chunks        = (stream_chunk_t*)malloc(nr_chunks * sizeof(stream_chunk_t));
+	reader->free_chunks   = (uint32_t*)malloc(nr_chunks * sizeof(uint32_t));
+	reader->filled_chunks = (uint32_t*)malloc(nr_chunks * sizeof(uint32_t));
+	for (uint32_t i = 0; i < nr_chunks; i++) {
+		reader->chunks[i]      = (stream_chunk_t){(char*)malloc(chunk_size), 0};
+		reader->free_chunks[i] = i;
+	}
+	reader->nr_free_chunks     = nr_chunks;
+	reader->first_filled_chunk = 0;
+	reader->nr_filled_chunks   = 0;
+
+	reader->carry         = (char*)malloc(chunk_size);
+	reader->carry_size    = 0;
+	reader->end_of_stream = false;
+
+	pthread_mutex_init(&reader->mutex, NULL);
+	pthread_cond_init(&reader->chunk_filled, NULL);
+	pthread_cond_init(&reader->chunk_freed, NULL);
+}
+
+void delete_stream_reader(stream_reader_t* reader) {
+	for (uint32_t i = 0; i < reader->nr_chunks; i++) {
+		free(reader->chunks[i].data);
+	}
+	free(reader->chunks);
+	free(reader->free_chunks);
+	free(reader->filled_chunks);
+	free(reader->carry);
+
+	pthread_mutex_destroy(&reader->mutex);
+	pthread_cond_destroy(&reader->chunk_filled);
+	pthread_cond_destroy(&reader->chunk_freed);
+}
+
+void* read_stream(void* reader_ptr) {
+
+	stream_reader_t* reader = (stream_reader_t*)reader_ptr;
+
+	bool is_first_chunk = true;
+	bool is_stream_over = false;
+	while (!is_stream_over) {
+
+		// Wait for the parsing threads to give back a chunk
+		pthread_mutex_lock(&reader->mutex);
+		while (reader->nr_free_chunks == 0) {
+			pthread_cond_wait(&reader->chunk_freed, &reader->mutex);
+		}
+		stream_chunk_t* chunk = &reader->chunks[reader->free_chunks[--reader->nr_free_chunks]];
+		pthread_mutex_unlock(&reader->mutex);
+
+		// The chunk starts with the incomplete line of the previous chunk
+		memcpy(chunk->data, reader->carry, reader->carry_size);
+		uint64_t bytes_in_chunk = reader->carry_size;
+
+		// Pipes may return less data than requested
+		while (bytes_in_chunk < reader->chunk_size) {
+			ssize_t bytes_read = read(reader->fd, chunk->data + bytes_in_chunk, reader->chunk_size - bytes_in_chunk);
+
+			if (bytes_read < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				printf("Cannot read the input stream.\n");
+				exit(1);
+			}
+
+			if (bytes_read == 0) {
+				is_stream_over = true;
+				break;
+			}
+			bytes_in_chunk += bytes_read;
+		}
+
+		if (is_first_chunk && is_binary_graph(chunk->data, bytes_in_chunk)) {
+			printf("Binary graphs cannot be read from a stream. Use the COO format.\n");
+			exit(1);
+		}
+		is_first_chunk = false;
+
+		if (is_stream_over) {
+			chunk->size        = bytes_in_chunk; // The last line may not end with '\n'
+			reader->carry_size = 0;
+		} else {
+			// Keep only complete lines, the last one is copied to the next chunk
+			char* last_newline = (char*)memrchr(chunk->data, '\n', bytes_in_chunk);
+			if (last_newline == NULL) {
+				printf("A line of the input stream is longer than the chunk size.\n");
+				exit(1);
+			}
+
+			chunk->size        = last_newline - chunk->data + 1;
+			reader->carry_size = bytes_in_chunk - chunk->size;
+			memcpy(reader->carry, chunk->data + chunk->size, reader->carry_size);
+		}
+
+		pthread_mutex_lock(&reader->mutex);
+		uint32_t filled_index = (reader->first_filled_chunk + reader->nr_filled_chunks) % reader->nr_chunks;
+		reader->filled_chunks[filled_index] = chunk - reader->chunks;
+		reader->nr_filled_chunks++;
+		reader->end_of_stream = is_stream_over;
+		pthread_cond_broadcast(&reader->chunk_filled);
+		pthread_mutex_unlock(&reader->mutex);
+	}
+
+	pthread_exit(NULL);
+}
+
+stream_chunk_t* get_stream_chunk(stream_reader_t* reader) {
+
+	pthread_mutex_lock(&reader->mutex);
+	while (reader->nr_filled_chunks == 0 && !reader->end_of_stream) {
+		pthread_cond_wait(&reader->chunk_filled, &reader->mutex);
+	}
+
+	// Nothing else to parse
+	if (reader->nr_filled_chunks == 0) {
+		pthread_mutex_unlock(&reader->mutex);
+		return NULL;
+	}
+
+	stream_chunk_t* chunk      = &reader->chunks[reader->filled_chunks[reader->first_filled_chunk]];
+	reader->first_filled_chunk = (reader->first_filled_chunk + 1) % reader->nr_chunks;
+	reader->nr_filled_chunks--;
+	pthread_mutex_unlock(&reader->mutex);
+
+	return chunk;
+}
+
+void release_stream_chunk(stream_reader_t* reader, stream_chunk_t* chunk) {
+	pthread_mutex_lock(&reader->mutex);
+	reader->free_chunks[reader->nr_free_chunks++] = chunk - reader->chunks;
+	pthread_cond_signal(&reader->chunk_freed);
+	pthread_mutex_unlock(&reader->mutex);
+}
@@ -0,0 +1,61 @@
+#ifndef __STREAM_READER_H__
+#define __STREAM_READER_H__
+
+#include <pthread.h> // Mutexes and condition variables
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+
+// Default size of each chunk read from a stream
+#ifndef STREAM_CHUNK_SIZE
+#define STREAM_CHUNK_SIZE (4 * 1024 * 1024)
+#endif
+
+// Section of the stream containing only complete lines
+typedef struct {
+	char*    data;
+	uint64_t size;
+} stream_chunk_t;
+
+// Ring of fixed-size buffers filled by a reader thread and consumed by the parsing threads.
+// Only nr_chunks buffers are allocated, so the memory used does not depend on the size of the stream
+typedef struct {
+	int      fd;
+	uint64_t chunk_size;
+	uint32_t nr_chunks;
+
+	stream_chunk_t* chunks;
+
+	// Chunks ready to be filled (stack) and ready to be parsed (in stream order)
+	uint32_t* free_chunks;
+	uint32_t  nr_free_chunks;
+	uint32_t* filled_chunks;
+	uint32_t  first_filled_chunk;
+	uint32_t  nr_filled_chunks;
+
+	// Last incomplete line of the previous chunk, copied at the start of the next one
+	char*    carry;
+	uint64_t carry_size;
+
+	bool end_of_stream;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t  chunk_filled;
+	pthread_cond_t  chunk_freed;
+} stream_reader_t;
+
+// Allocate the ring of buffers. The stream is read from fd
+void create_stream_reader(stream_reader_t* reader, int fd, uint32_t nr_chunks, uint64_t chunk_size);
+
+// Free the buffers of the ring. Does not close the file descriptor
+void delete_stream_reader(stream_reader_t* reader);
+
+// Function executed by the reader thread. Fills the free chunks until the end of the stream
+void* read_stream(void* reader);
+
+// Returns the next chunk to parse, waiting for the reader thread if necessary. Returns NULL at the end of the stream
+stream_chunk_t* get_stream_chunk(stream_reader_t* reader);
+
+// Give back a parsed chunk, so that the reader thread can fill it again
+void release_stream_chunk(stream_reader_t* reader, stream_chunk_t* chunk);
+
+#endif /* __STREAM_READER_H__ */
@@ -0,0 +1,16 @@
+#include <stdint.h> // Fixed size integers
+#include <stdlib.h> // Various
+
+#include "../common/common.h"
+#include "write_combining.h"
+
+void create_wc_buffers(wc_buffers_t* buffers, uint32_t nr_batches) {
+	buffers->nr_batches = nr_batches;
+	buffers->lines      = (edge_t*)aligned_alloc(CACHE_LINE_SIZE, nr_batches * WC_BUFFER_EDGES * sizeof(edge_t));
+	buffers->nr_edges   = (uint8_t*)calloc(nr_batches, sizeof(uint8_t));
+}
+
+void delete_wc_buffers(wc_buffers_t* buffers) {
+	free(buffers->lines);
+	free(buffers->nr_edges);
+}
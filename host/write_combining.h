@@ -0,0 +1,88 @@
+#ifndef __WRITE_COMBINING_H__
+#define __WRITE_COMBINING_H__
+
+#include <stdbool.h> // Booleans
+#include <stdint.h>  // Fixed size integers
+#include <string.h>  // Copy the partial lines
+
+#if defined(__SSE2__)
+#include <immintrin.h> // Non-temporal stores
+#endif
+
+#include "../common/common.h"
+
+#define CACHE_LINE_SIZE 64
+
+// Edges in each write-combining buffer: a cache line
+#define WC_BUFFER_EDGES (CACHE_LINE_SIZE / sizeof(edge_t))
+
+// Below this number of batches, the edges are written directly to their batches: their lines stay in the cache anyway,
+// and routing_bench is slower with the buffers at 8 colors (120 triplets), and faster from 10 colors (220 triplets) on
+#ifndef WC_MIN_BATCHES
+#define WC_MIN_BATCHES 200
+#endif
+
+// Small buffers of a thread, one cache line for each batch. The edges routed to a batch are gathered in its line,
+// which stays in the cache, and the big batches are only written a full line at a time. Scattering every edge
+// directly to its batches touches a different cache line and page for each DPU, which misses the cache and the TLB
+// with many colors
+typedef struct {
+	edge_t*  lines;    // WC_BUFFER_EDGES edges for each batch, aligned to cache lines
+	uint8_t* nr_edges; // Edges in the line of each batch
+	uint32_t nr_batches;
+} wc_buffers_t;
+
+void create_wc_buffers(wc_buffers_t* buffers, uint32_t nr_batches);
+
+void delete_wc_buffers(wc_buffers_t* buffers);
+
+// Add the edge to the line of the batch. Returns true if the line is full: it must be copied to the batch, and
+// emptied with clear_wc_buffer
+static inline bool add_to_wc_buffer(wc_buffers_t* buffers, uint32_t batch, edge_t edge) {
+	uint8_t nr_edges = buffers->nr_edges[batch];
+
+	buffers->lines[batch * WC_BUFFER_EDGES + nr_edges] = edge;
+	buffers->nr_edges[batch]                           = nr_edges + 1;
+
+	return nr_edges + 1 == WC_BUFFER_EDGES;
+}
+
+static inline edge_t* get_wc_buffer(const wc_buffers_t* buffers, uint32_t batch) {
+	return &buffers->lines[batch * WC_BUFFER_EDGES];
+}
+
+static inline void clear_wc_buffer(wc_buffers_t* buffers, uint32_t batch) {
+	buffers->nr_edges[batch] = 0;
+}
+
+// Copy edges to a batch. A full line copied to a cache line of the batch bypasses the cache with non-temporal stores:
+// the batches are only read again by the transfers to the DPUs, so they would only evict useful data. Other copies
+// are normal stores. The non-temporal stores must be ordered with store_fence before the edges are published to other
+// threads
+static inline void copy_edges_to_batch(edge_t* batch_edges, const edge_t* edges, uint32_t nr_edges) {
+#if defined(__SSE2__)
+	if (nr_edges == WC_BUFFER_EDGES && ((uintptr_t)batch_edges % CACHE_LINE_SIZE) == 0) {
+#if defined(__AVX512F__)
+		_mm512_stream_si512((__m512i*)batch_edges, _mm512_loadu_si512((const __m512i*)edges));
+#elif defined(__AVX__)
+		_mm256_stream_si256((__m256i*)batch_edges, _mm256_loadu_si256((const __m256i*)edges));
+		_mm256_stream_si256((__m256i*)batch_edges + 1, _mm256_loadu_si256((const __m256i*)edges + 1));
+#else
+		for (uint32_t i = 0; i < CACHE_LINE_SIZE / sizeof(__m128i); i++) {
+			_mm_stream_si128((__m128i*)batch_edges + i, _mm_loadu_si128((const __m128i*)edges + i));
+		}
+#endif
+		return;
+	}
+#endif
+	memcpy(batch_edges, edges, nr_edges * sizeof(edge_t));
+}
+
+// Make the non-temporal stores visible to the other threads before the following stores
+static inline void store_fence() {
+#if defined(__SSE2__)
+	_mm_sfence();
+#endif
+}
+
+#endif /* __WRITE_COMBINING_H__ */
@@ -0,0 +1,134 @@
+// Convert a graph in plain COO format to the binary edge list read by the host application.
+// The edges are normalized (u < v), so that the host does not need to order them again. The self-loops cannot be
+// normalized, they are dropped
+#include <fcntl.h>
+#include <stdbool.h>  // Booleans
+#include <stdint.h>   // Fixed size integers
+#include <stdio.h>    // Print and write the output file
+#include <stdlib.h>   // Various
+#include <string.h>   // Copy the magic string
+#include <sys/mman.h> // mmap
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../common/common.h"
+#include "../host/binary_graph.h"
+#include "../host/coo_parser.h"
+
+// Number of edges written to the output file at once
+#define OUTPUT_BUFFER_EDGES (1 << 20)
+
+// Exits if the output file cannot be written, so that no partial graph is left without an error
+static void write_output(const void* data, size_t size, size_t count, FILE* output) {
+	if (fwrite(data, size, count, output) != count) {
+		printf("Cannot write the output file.\n");
+		exit(1);
+	}
+}
+
+int main(int argc, char* argv[]) {
+
+	// With -r, the graph is for the runs with deletions or windows, whose DPUs take the node ids with the bit of
+	// EDGE_DELETION_FLAG for deletions
+	bool is_dynamic = argc == 4 && strcmp(argv[1], "-r") == 0;
+	if (argc != 3 && !is_dynamic) {
+		printf("Usage: %s [-r] path_to_coo_file path_to_binary_file\n", argv[0]);
+		return 1;
+	}
+	const char* input_path  = argv[argc - 2];
+	const char* output_path = argv[argc - 1];
+
+	struct stat file_stat;
+	if (stat(input_path, &file_stat) != 0) {
+		printf("File does not exist.\n");
+		return 1;
+	}
+
+	int file_fd = open(input_path, O_RDONLY);
+	if (file_fd < 0) {
+		printf("Cannot open the input file.\n");
+		return 1;
+	}
+	const char* mmaped_file = (const char*)mmap(0, file_stat.st_size, PROT_READ, MAP_PRIVATE, file_fd, 0);
+	close(file_fd);
+	if (mmaped_file == MAP_FAILED) { // Also for empty files and directories
+		printf("Cannot map the input file.\n");
+		return 1;
+	}
+	madvise((void*)mmaped_file, file_stat.st_size, MADV_SEQUENTIAL);
+
+	FILE* output = fopen(output_path, "wb");
+	if (output == NULL) {
+		printf("Cannot create the output file.\n");
+		return 1;
+	}
+
+	// The header is written again at the end, when the number of edges and the max node id are known
+	binary_graph_header_t header = {.version = BINARY_GRAPH_VERSION, .flags = BINARY_GRAPH_NORMALIZED};
+	memcpy(header.magic, BINARY_GRAPH_MAGIC, sizeof(header.magic));
+	write_output(&header, sizeof(header), 1, output);
+
+	edge_t*  output_buffer       = (edge_t*)malloc(OUTPUT_BUFFER_EDGES * sizeof(edge_t));
+	uint32_t edges_output_buffer = 0;
+
+	uint64_t self_loops = 0;
+	uint64_t pos        = 0;
+	while (pos < (uint64_t)file_stat.st_size) {
+		edge_t edge;
+		bool   is_valid_edge;
+		pos = parse_coo_line(mmaped_file, pos, file_stat.st_size, &edge, &is_valid_edge);
+
+		if (!is_valid_edge) {
+			continue;
+		}
+
+		if (is_dynamic && ((edge.u | edge.v) & EDGE_DELETION_FLAG)) {
+			printf("With -r, the node ids must be lower than 2^31. Invalid edge: %u %u\n", edge.u, edge.v);
+			fclose(output);
+			unlink(output_path);
+			return 1;
+		}
+
+		// The header claims u < v for every edge, so the self-loops are not written
+		if (edge.u == edge.v) {
+			self_loops++;
+			continue;
+		}
+
+		if (edge.u > edge.v) { // Nodes in edge need to be ordered
+			edge = (edge_t){edge.v, edge.u};
+		}
+
+		if (edge.v > header.max_node_id) {
+			header.max_node_id = edge.v;
+		}
+
+		output_buffer[edges_output_buffer++] = edge;
+		header.nr_edges++;
+
+		if (edges_output_buffer == OUTPUT_BUFFER_EDGES) {
+			write_output(output_buffer, sizeof(edge_t), edges_output_buffer, output);
+			edges_output_buffer = 0;
+		}
+	}
+	write_output(output_buffer, sizeof(edge_t), edges_output_buffer, output);
+
+	if (fseek(output, 0, SEEK_SET) != 0) {
+		printf("Cannot write the output file.\n");
+		return 1;
+	}
+	write_output(&header, sizeof(header), 1, output);
+
+	if (fclose(output) != 0) {
+		printf("Cannot write the output file.\n");
+		return 1;
+	}
+
+	printf("Converted %lu edges (max node id %u), %lu self-loops dropped.\n", header.nr_edges, header.max_node_id,
+	       self_loops);
+
+	free(output_buffer);
+	munmap((void*)mmaped_file, file_stat.st_size);
+
+	return 0;
+}